@@ -30,7 +30,8 @@ import m5
 from m5.objects import *
 from m5.defines import buildEnv
 from m5.util import addToPath
-import os, argparse, sys
+from m5.util.convert import toFrequency
+import os, argparse, sys, csv, json
 
 addToPath("../")
 
@@ -124,6 +125,115 @@ parser.add_argument(
     help="Multicast probability of total messages (multicast packets are inject on vent 0)"
 )
 
+parser.add_argument(
+    "--multicast-pattern",
+    default="none",
+    choices=["none", "broadcast", "row", "column", "nearest", "sharers"],
+    help="""destinations of the multicast packets. With 'none' the
+    network picks them (see --multicast-groups); otherwise the tester picks
+    them and records when each packet reaches all of its destinations,
+    and --multicast-groups is none.""",
+)
+
+parser.add_argument(
+    "--nearest-fan-out",
+    type=int,
+    default=4,
+    help="destinations of a multicast packet in the nearest pattern",
+)
+
+parser.add_argument(
+    "--sharer-distribution",
+    type=str,
+    default="1",
+    help="""comma-separated relative frequencies of 1, 2, 3, ...
+    destinations of a multicast packet in the sharers pattern""",
+)
+
+parser.add_argument(
+    "--checkpoint-at",
+    type=int,
+    default=0,
+    help="""take a checkpoint at this tick, in <outdir>/cpt.<tick>, then
+    run on; the testers stop injecting for --checkpoint-quiesce-cycles
+    before it, so that no packet waits in a protocol buffer""",
+)
+
+parser.add_argument(
+    "--checkpoint-quiesce-cycles",
+    type=int,
+    default=10,
+    help="network cycles without injection before --checkpoint-at",
+)
+
+parser.add_argument(
+    "--restore-checkpoint",
+    type=str,
+    default="",
+    help="restore the checkpoint in this directory",
+)
+
+parser.add_argument(
+    "--sweep-rates",
+    type=str,
+    default="",
+    help="""run a latency-vs-injection-rate sweep in this process instead
+    of a single point. Either comma-separated rates or start:stop:step.""",
+)
+
+parser.add_argument(
+    "--sweep-multicast-probs",
+    type=str,
+    default="",
+    help="""comma-separated multicast probabilities; the sweep runs one
+    curve per probability (default: --multicast-prob)""",
+)
+
+parser.add_argument(
+    "--sweep-network-multicast",
+    default="",
+    choices=["", "on", "off", "both"],
+    help="""run the curves with network multicast, multiple unicast, or
+    both (default: as set by --multicast)""",
+)
+
+parser.add_argument(
+    "--sweep-warmup-cycles",
+    type=int,
+    default=2000,
+    help="network cycles run before measuring each point of a sweep",
+)
+
+parser.add_argument(
+    "--sweep-measure-cycles",
+    type=int,
+    default=20000,
+    help="network cycles measured at each point of a sweep",
+)
+
+parser.add_argument(
+    "--sweep-drain-cycles",
+    type=int,
+    default=100000,
+    help="""network cycles a sweep waits for the packets of a point to be
+    delivered before the next one; the sweep fails if they are not""",
+)
+
+parser.add_argument(
+    "--sweep-saturation-factor",
+    type=float,
+    default=3.0,
+    help="""a curve saturates, and its sweep stops, once the completion
+    latency exceeds this multiple of the latency at its lowest rate""",
+)
+
+parser.add_argument(
+    "--sweep-output",
+    type=str,
+    default="sweep",
+    help="the sweep writes <name>.csv and <name>.json to the output directory",
+)
+
 #
 # Add the ruby specific and protocol specific options
 #
@@ -131,18 +241,28 @@ Ruby.define_options(parser)
 
 args = parser.parse_args()
 
+# The tester records when a packet reaches the destinations it picked, so
+# the network must not add members of its own to them
+if args.multicast_pattern != "none":
+    args.multicast_groups = "none"
+
 cpus = [
     GarnetSyntheticTraffic(
         num_packets_max=args.num_packets_max,
         single_sender=args.single_sender_id,
         single_dest=args.single_dest_id,
-        sim_cycles=args.sim_cycles,
         traffic_type=args.synthetic,
         inj_rate=args.injectionrate,
         inj_vnet=args.inj_vnet,
         precision=args.precision,
         num_dest=args.num_dirs,
         multicast_prob=args.multicast_prob,
+        sim_cycles=m5.MaxTick if args.sweep_rates else args.sim_cycles,
+        multicast_pattern=args.multicast_pattern,
+        multicast_fan_out=args.nearest_fan_out,
+        sharer_distribution=[
+            float(f) for f in args.sharer_distribution.split(",")
+        ],
     )
     for i in range(args.num_cpus)
 ]
@@ -171,6 +291,8 @@ for ruby_port in system.ruby._cpu_ports:
     # Tie the cpu test ports to the ruby cpu port
     #
     cpus[i].test = ruby_port.in_ports
+    if args.garnet_partitions > 1:
+        cpus[i].eventq_index = ruby_port.eventq_index
     i += 1
 
 # -----------------------
@@ -180,13 +302,217 @@ for ruby_port in system.ruby._cpu_ports:
 root = Root(full_system=False, system=system)
 root.system.mem_mode = "timing"
 
+# The partitions of the network synchronize once per link traversal
+if args.garnet_partitions > 1:
+    root.sim_quantum = int(
+        args.link_latency * 1e12 / toFrequency(args.ruby_clock)
+    )
+
 # Not much point in this being higher than the L1 latency
 m5.ticks.setGlobalFrequency("1ps")
 
 # instantiate configuration
-m5.instantiate()
+if args.restore_checkpoint:
+    m5.instantiate(args.restore_checkpoint)
+else:
+    m5.instantiate()
+
+
+# -----------------------
+# injection rate sweep
+# -----------------------
+
+
+def parse_rates(spec):
+    if ":" in spec:
+        start, stop, step = (float(x) for x in spec.split(":"))
+        count = int(round((stop - start) / step)) + 1
+        return [round(start + i * step, 9) for i in range(count)]
+    return [float(rate) for rate in spec.split(",")]
+
+
+def measure_point(legacy_stats, ruby_period):
+    """Summarize the stats of the point that just ran."""
+
+    def tester_total(name):
+        return sum(cpu.resolveStat(name).value for cpu in cpus)
+
+    def tester_mean(name):
+        total = samples = 0
+        for cpu in cpus:
+            stat = cpu.resolveStat(name)
+            n = sum(stat.values) + stat.underflow + stat.overflow
+            total += stat.sum
+            samples += n
+        return total / samples if samples else 0.0
+
+    def network_total(name):
+        stat = legacy_stats.get(f"{system.ruby.network.path()}.{name}")
+        return stat.total if stat is not None else float("nan")
+
+    packets = tester_total("packets")
+    completed = tester_total("completedPackets")
+    return {
+        "packets": int(packets),
+        "multicast_packets": int(tester_total("multicastPackets")),
+        "completed_packets": int(completed),
+        "accepted_ratio": completed / packets if packets else 1.0,
+        "completion_latency": tester_mean("completionLatency"),
+        "multicast_completion_latency": tester_mean(
+            "multicastCompletionLatency"
+        ),
+        "delivery_latency": tester_mean("deliveryLatency"),
+        "network_packet_latency": network_total("average_packet_latency")
+        / ruby_period,
+    }
+
+
+def simulate_for(ticks):
+    exit_event = m5.simulate(ticks)
+    if exit_event.getCause() != "simulate() limit reached":
+        sys.exit(f"Sweep stopped: {exit_event.getCause()}")
+
+
+def drain(ruby_period):
+    """Stop injecting and run until every packet has been delivered."""
+    for cpu in cpus:
+        cpu.setInjectionRate(0)
+    deadline = m5.curTick() + args.sweep_drain_cycles * ruby_period
+    while sum(cpu.outstandingPackets() for cpu in cpus) > 0:
+        if m5.curTick() >= deadline:
+            sys.exit(
+                "Sweep stopped: the network did not drain in "
+                f"{args.sweep_drain_cycles} cycles"
+            )
+        simulate_for(100 * ruby_period)
+
+
+def run_sweep():
+    ruby_period = int(1e12 / toFrequency(args.ruby_clock))
+    warmup = args.sweep_warmup_cycles * ruby_period
+    measure = args.sweep_measure_cycles * ruby_period
+
+    rates = parse_rates(args.sweep_rates)
+    probs = [args.multicast_prob]
+    if args.sweep_multicast_probs:
+        probs = [int(p) for p in args.sweep_multicast_probs.split(",")]
+    network_modes = {
+        "": [bool(args.multicast)],
+        "on": [True],
+        "off": [False],
+        "both": [True, False],
+    }[args.sweep_network_multicast]
+
+    legacy_stats = {stat.name: stat for stat in m5.stats.stats_list}
+    points = []
+    for network_multicast in network_modes:
+        # Never switch the network while it carries packets
+        drain(ruby_period)
+        system.ruby.network.setMulticastEnabled(network_multicast)
+        for prob in probs:
+            # Unicast traffic does not depend on network multicast
+            if prob == 0 and network_multicast != network_modes[0]:
+                continue
+            zero_load = None
+            for rate in rates:
+                # Start every point from an empty network, so that no
+                # packet of the previous point is measured in this one
+                drain(ruby_period)
+                m5.stats.reset()
+                for cpu in cpus:
+                    cpu.setInjectionRate(rate)
+                    cpu.setMulticastProb(prob)
+
+                simulate_for(warmup)
+                m5.stats.reset()
+                simulate_for(measure)
+                m5.stats.dump()
+
+                point = {
+                    "network_multicast": network_multicast,
+                    "multicast_prob": prob,
+                    "injection_rate": rate,
+                }
+                point.update(measure_point(legacy_stats, ruby_period))
+
+                latency = point["completion_latency"]
+                if zero_load is None:
+                    zero_load = latency
+                point["saturated"] = (
+                    latency > args.sweep_saturation_factor * zero_load
+                    or point["accepted_ratio"] < 0.9
+                )
+                points.append(point)
+                print(
+                    "multicast={} prob={} rate={:.4f} latency={:.2f} "
+                    "accepted={:.3f}{}".format(
+                        network_multicast,
+                        prob,
+                        rate,
+                        latency,
+                        point["accepted_ratio"],
+                        " saturated" if point["saturated"] else "",
+                    )
+                )
+                if point["saturated"]:
+                    break
+
+    out_base = os.path.join(m5.options.outdir, args.sweep_output)
+    with open(out_base + ".csv", "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=list(points[0].keys()))
+        writer.writeheader()
+        writer.writerows(points)
+    with open(out_base + ".json", "w") as f:
+        json.dump(
+            {
+                "topology": args.topology,
+                "synthetic": args.synthetic,
+                "multicast_pattern": args.multicast_pattern,
+                "warmup_cycles": args.sweep_warmup_cycles,
+                "measure_cycles": args.sweep_measure_cycles,
+                "points": points,
+            },
+            f,
+            indent=2,
+        )
+    print(f"Sweep written to {out_base}.csv and {out_base}.json")
+
+
+def take_checkpoint(tick):
+    """Checkpoint at tick and reset the stats, so that what runs after it
+    can be compared with a restore of the checkpoint.
+
+    The MessageBuffers of the protocol are not checkpointed, only the
+    flits in the network are, so the testers are quiet before the
+    checkpoint."""
+    ruby_period = int(1e12 / toFrequency(args.ruby_clock))
+    quiet = max(tick - args.checkpoint_quiesce_cycles * ruby_period, 0)
+    if m5.curTick() < quiet:
+        exit_event = m5.simulate(quiet - m5.curTick())
+        if exit_event.getCause() != "simulate() limit reached":
+            return exit_event
+    for cpu in cpus:
+        cpu.setInjectionRate(0)
+    exit_event = m5.simulate(tick - m5.curTick())
+    if exit_event.getCause() != "simulate() limit reached":
+        return exit_event
+    for cpu in cpus:
+        cpu.setInjectionRate(args.injectionrate)
+
+    m5.checkpoint(os.path.join(m5.options.outdir, f"cpt.{tick}"))
+    m5.stats.dump()
+    m5.stats.reset()
+    return None
+
 
-# simulate until program terminates
-exit_event = m5.simulate(args.abs_max_tick)
+if args.sweep_rates:
+    run_sweep()
+else:
+    exit_event = None
+    if args.checkpoint_at:
+        exit_event = take_checkpoint(args.checkpoint_at)
+    if exit_event is None:
+        # simulate until program terminates
+        exit_event = m5.simulate(args.abs_max_tick - m5.curTick())
 
-print("Exiting @ tick", m5.curTick(), "because", exit_event.getCause())
+    print("Exiting @ tick", m5.curTick(), "because", exit_event.getCause())
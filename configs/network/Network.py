@@ -95,7 +95,9 @@ def define_options(parser):
         help="""routing algorithm in network.
             0: weight-based table
             1: XY (for Mesh. see garnet/RoutingUnit.cc)
-            2: Custom (see garnet/RoutingUnit.cc""",
+            2: Custom (see garnet/RoutingUnit.cc)
+            3: West-first adaptive (for Mesh)
+            4: Odd-even adaptive (for Mesh)""",
     )
     parser.add_argument(
         "--network-fault-model",
@@ -125,6 +127,31 @@ def define_options(parser):
         default=50000,
         help="network-level deadlock threshold.",
     )
+    parser.add_argument(
+        "--garnet-bypass",
+        action="store_true",
+        default=False,
+        help="""let single-flit packets arriving at an idle garnet router
+        skip the buffering stages of the router pipeline.""",
+    )
+    parser.add_argument(
+        "--garnet-flit-trace",
+        action="store",
+        type=str,
+        default="",
+        help="""record every flit of the garnet network to this binary file
+        in the output directory; read it with util/garnet_flit_trace.py.""",
+    )
+    parser.add_argument(
+        "--garnet-partitions",
+        action="store",
+        type=int,
+        default=1,
+        help="""spread the garnet routers over this many event queues,
+        by mesh region. The simulation quantum (Root.sim_quantum) cannot
+        be longer than the latency of the links between regions. Only
+        supported with the Garnet_standalone protocol.""",
+    )
     parser.add_argument(
         "--simple-physical-channels",
         action="store_true",
@@ -135,8 +162,135 @@ def define_options(parser):
     parser.add_argument(
         "--multicast",
         action="store_true",
+        default=None,
+        help="""Enable multicast routing. Default is multiple-unicast for
+            garnet, and multicast (a tree of messages) for simple.""",
+    )
+    parser.add_argument(
+        "--no-multicast",
+        action="store_false",
+        dest="multicast",
+        help="Send a message to several destinations as multiple-unicast.",
+    )
+    parser.add_argument(
+        "--hybrid-multicast",
+        action="store_true",
+        default=False,
+        help="""with --multicast, let each NI choose per message between
+            multicast, multiple-unicast, or multicast to the clustered
+            destinations and unicast to the stragglers.""",
+    )
+    parser.add_argument(
+        "--straggler-hops",
+        action="store",
+        type=int,
+        default=2,
+        help="""--hybrid-multicast: hops beyond which a destination far
+            from all the other destinations is a straggler.""",
+    )
+    parser.add_argument(
+        "--hybrid-load-weight",
+        action="store",
+        type=float,
+        default=1.0,
+        help="""--hybrid-multicast: cycles charged per flit hop a path
+            adds to the network when the NI output VCs are all busy.""",
+    )
+    parser.add_argument(
+        "--auth-tags-in-flits",
+        action="store_true",
         default=False,
-        help="Enable multicast routing. Default is multiple-unicast.",
+        help="""add the bytes of the authentication tags to the flits
+            of the packets.""",
+    )
+    parser.add_argument(
+        "--mac-lanes",
+        action="store",
+        type=int,
+        default=1,
+        help="parallel lanes of the MAC engine of each NI.",
+    )
+    parser.add_argument(
+        "--mac-pipeline-stages",
+        action="store",
+        type=int,
+        default=1,
+        help="pipeline stages of a MAC engine lane.",
+    )
+    parser.add_argument(
+        "--mac-queue-depth",
+        action="store",
+        type=int,
+        default=0,
+        help="tags per vnet that can wait for a MAC engine lane.",
+    )
+    parser.add_argument(
+        "--multicast-groups",
+        action="store",
+        type=str,
+        default="uniform",
+        choices=["none", "fixed", "uniform", "clustered", "trace", "replay"],
+        help="""how garnet turns the destination of a message into a
+            multicast group: none keeps the protocol destinations,
+            fixed uses the --multicast-group-list groups in turn,
+            uniform picks random machines, clustered picks random
+            machines near the destination, trace reads the groups
+            from --multicast-group-file and replay replays the groups
+            recorded in --multicast-group-file.""",
+    )
+    parser.add_argument(
+        "--multicast-vnets",
+        action="store",
+        type=int,
+        nargs="+",
+        default=[0],
+        help="vnets whose messages are turned into multicast groups.",
+    )
+    parser.add_argument(
+        "--multicast-fan-out",
+        action="store",
+        type=int,
+        default=8,
+        help="destinations in a uniform or clustered multicast group.",
+    )
+    parser.add_argument(
+        "--multicast-cluster-radius",
+        action="store",
+        type=int,
+        default=2,
+        help="mesh distance bounding a clustered multicast group.",
+    )
+    parser.add_argument(
+        "--multicast-group-list",
+        action="store",
+        type=str,
+        default="",
+        help="""fixed multicast groups separated by ';', each a
+            space-separated list of machine indices.""",
+    )
+    parser.add_argument(
+        "--multicast-group-file",
+        action="store",
+        type=str,
+        default="",
+        help="""file with one multicast group per line, or groups
+            recorded with --multicast-record-file.""",
+    )
+    parser.add_argument(
+        "--multicast-seed",
+        action="store",
+        type=int,
+        default=1,
+        help="""seed of the random multicast group streams of the
+            NIs.""",
+    )
+    parser.add_argument(
+        "--multicast-record-file",
+        action="store",
+        type=str,
+        default="",
+        help="""record the multicast groups picked by each NI to this
+            binary file in the output directory, for replay.""",
     )
 
 
@@ -190,8 +344,18 @@ def init_network(options, network, InterfaceClass):
         network.routing_algorithm = options.routing_algorithm
         network.multicast_mac_cycles = options.multicast_mac_cycles
         network.multicast_verify_cycles = options.multicast_verify_cycles
+        network.auth_tags_in_flits = options.auth_tags_in_flits
+        network.mac_lanes = options.mac_lanes
+        network.mac_pipeline_stages = options.mac_pipeline_stages
+        network.mac_queue_depth = options.mac_queue_depth
         network.garnet_deadlock_threshold = options.garnet_deadlock_threshold
-        network.enable_multicast = options.multicast
+        network.enable_multicast = bool(options.multicast)
+        network.hybrid_multicast = options.hybrid_multicast
+        network.straggler_hops = options.straggler_hops
+        network.hybrid_load_weight = options.hybrid_load_weight
+        network.enable_bypass = options.garnet_bypass
+        network.flit_trace_file = options.garnet_flit_trace
+        network.multicast_groups = create_multicast_groups(options)
 
         # Create Bridges and connect them to the corresponding links
         for intLink in network.int_links:
@@ -286,6 +450,9 @@ def init_network(options, network, InterfaceClass):
             extLink.int_cred_bridge = int_cred_bridges
 
     if options.network == "simple":
+        # Keep the default tree delivery unless asked otherwise
+        if options.multicast is not None:
+            network.enable_multicast = options.multicast
         if options.simple_physical_channels:
             network.physical_vnets_channels = [1] * int(
                 network.number_of_virtual_networks
@@ -298,7 +465,51 @@ def init_network(options, network, InterfaceClass):
         ]
         network.netifs = netifs
 
+    if options.network == "garnet":
+        network.partition_by_region(options.garnet_partitions)
+
     if options.network_fault_model:
         assert options.network == "garnet"
         network.enable_fault_model = True
         network.fault_model = FaultModel()
+
+
+def create_multicast_groups(options):
+    groups = pick_multicast_groups(options)
+    if groups is not NULL:
+        groups.seed = options.multicast_seed
+        groups.record_file = options.multicast_record_file
+    return groups
+
+
+def pick_multicast_groups(options):
+    vnets = options.multicast_vnets
+
+    if options.multicast_groups == "none":
+        return NULL
+    if options.multicast_groups == "fixed":
+        groups = [g for g in options.multicast_group_list.split(";") if g]
+        if not groups:
+            fatal("--multicast-groups=fixed needs --multicast-group-list")
+        return FixedMulticastGroups(vnets=vnets, groups=groups)
+    if options.multicast_groups == "clustered":
+        return ClusteredMulticastGroups(
+            vnets=vnets,
+            fan_out=options.multicast_fan_out,
+            radius=options.multicast_cluster_radius,
+        )
+    if options.multicast_groups == "trace":
+        if not options.multicast_group_file:
+            fatal("--multicast-groups=trace needs --multicast-group-file")
+        return TraceMulticastGroups(
+            vnets=vnets, trace_file=options.multicast_group_file
+        )
+    if options.multicast_groups == "replay":
+        if not options.multicast_group_file:
+            fatal("--multicast-groups=replay needs --multicast-group-file")
+        return ReplayMulticastGroups(
+            vnets=vnets, replay_file=options.multicast_group_file
+        )
+    return UniformMulticastGroups(
+        vnets=vnets, fan_out=options.multicast_fan_out
+    )
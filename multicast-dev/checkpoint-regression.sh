@@ -0,0 +1,59 @@
+# Checkpoint regression of Garnet: a 4x4 mesh is checkpointed mid-run
+# with flits in flight, then restored, and the rest of the run must
+# deliver the same packets as the run that took the checkpoint.
+# The flits restored as ghosts have no message, so they are not
+# completed at the tester, but they are delivered:
+#   generated packets           reference == restored
+#   received + ghost packets    reference == restored
+#   completed packets           reference == restored completed + ghosts
+GEM5=${GEM5:-../build/NULL/gem5.opt}
+OUTDIR=${OUTDIR:-checkpoint-regression}
+CPT_TICK=${CPT_TICK:-5000000}
+
+ARGS="--network=garnet \
+	--num-cpus=16 \
+	--num-dirs=16 \
+	--topology=Mesh_XY \
+	--mesh-rows=4 \
+	--sim-cycles=10000000 \
+	--synthetic=uniform_random \
+	--injectionrate=0.1"
+
+$GEM5 --outdir=$OUTDIR/reference \
+	../configs/example/garnet_synth_traffic.py $ARGS \
+	--checkpoint-at=$CPT_TICK || exit 1
+$GEM5 --outdir=$OUTDIR/restored \
+	../configs/example/garnet_synth_traffic.py $ARGS \
+	--restore-checkpoint=$OUTDIR/reference/cpt.$CPT_TICK || exit 1
+
+# Sum of the stats matching $2 in the last dump of the stats file $1
+last_dump() {
+	awk -v pat="$2" '
+		/Begin Simulation Statistics/ { sum = 0 }
+		$1 ~ pat { sum += $2 }
+		END { print sum }' $1/stats.txt
+}
+
+TESTER='^system\.cpu[0-9]+\.'
+NET='^system\.ruby\.network\.'
+ref_packets=$(last_dump $OUTDIR/reference "${TESTER}packets$")
+ref_received=$(last_dump $OUTDIR/reference "${NET}packets_received::total$")
+ref_ghosts=$(last_dump $OUTDIR/reference "${NET}ghost_packets_received::total$")
+ref_completed=$(last_dump $OUTDIR/reference "${TESTER}completedPackets$")
+res_packets=$(last_dump $OUTDIR/restored "${TESTER}packets$")
+res_received=$(last_dump $OUTDIR/restored "${NET}packets_received::total$")
+res_ghosts=$(last_dump $OUTDIR/restored "${NET}ghost_packets_received::total$")
+res_completed=$(last_dump $OUTDIR/restored "${TESTER}completedPackets$")
+
+echo "generated: $ref_packets / $res_packets"
+echo "received: $ref_received + $ref_ghosts ghosts /" \
+	"$res_received + $res_ghosts ghosts"
+echo "completed: $ref_completed / $res_completed"
+
+[ "$ref_packets" = "$res_packets" ] &&
+[ $((ref_received + ref_ghosts)) = $((res_received + res_ghosts)) ] &&
+[ "$ref_completed" = $((res_completed + res_ghosts)) ] || {
+	echo "FAIL: the restored run delivered different packets"
+	exit 1
+}
+echo "PASS"
@@ -0,0 +1,27 @@
+# Host-time overhead of the flit trace (--garnet-flit-trace) on an 8x8
+# mesh at a moderate injection rate: the same run without the trace, and
+# with it. Compare hostSeconds; the size of flits.bin is the amount of
+# trace written.
+GEM5=${GEM5:-../build/NULL/gem5.opt}
+OUTDIR=${OUTDIR:-flit-trace-bench}
+
+ARGS="--network=garnet \
+	--num-cpus=64 \
+	--num-dirs=64 \
+	--topology=Mesh_XY \
+	--mesh-rows=8 \
+	--sim-cycles=100000 \
+	--synthetic=uniform_random \
+	--injectionrate=0.1"
+
+$GEM5 --outdir=$OUTDIR/off \
+	../configs/example/garnet_synth_traffic.py $ARGS || exit 1
+$GEM5 --outdir=$OUTDIR/on \
+	../configs/example/garnet_synth_traffic.py $ARGS \
+	--garnet-flit-trace=flits.bin || exit 1
+
+for run in off on; do
+	echo "$run:"
+	grep -E "^(hostSeconds|simTicks)" $OUTDIR/$run/stats.txt
+done
+ls -l $OUTDIR/on/flits.bin
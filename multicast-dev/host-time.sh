@@ -0,0 +1,39 @@
+# Runs one garnet_synth_traffic.py workload and prints its host time, to
+# compare two gem5 builds on the same workload:
+#   GEM5=../build/NULL/gem5.opt.base ./host-time.sh flitbuffer
+#   GEM5=../build/NULL/gem5.opt ./host-time.sh flitbuffer
+# Workloads:
+#   sa          8x8 mesh, uniform random multicast at 0.02
+#   wakeup      16x16 mesh, uniform random unicast at 0.02
+#   flitbuffer  8x8 mesh, uniform random unicast at 0.5 (saturated)
+GEM5=${GEM5:-../build/NULL/gem5.opt}
+WORKLOAD=$1
+OUTDIR=${OUTDIR:-host-time-$WORKLOAD}
+
+case $WORKLOAD in
+sa)
+	ROWS=8 CYCLES=200000 RATE=0.02 EXTRA=--multicast ;;
+wakeup)
+	ROWS=16 CYCLES=100000 RATE=0.02 EXTRA= ;;
+flitbuffer)
+	ROWS=8 CYCLES=200000 RATE=0.5 EXTRA= ;;
+*)
+	echo "usage: $0 sa|wakeup|flitbuffer" >&2
+	exit 1 ;;
+esac
+NODES=$((ROWS * ROWS))
+
+$GEM5 \
+	--outdir=$OUTDIR \
+	../configs/example/garnet_synth_traffic.py \
+	--network=garnet \
+	--num-cpus=$NODES \
+	--num-dirs=$NODES \
+	--topology=Mesh_XY \
+	--mesh-rows=$ROWS \
+	$EXTRA \
+	--sim-cycles=$CYCLES \
+	--synthetic=uniform_random \
+	--injectionrate=$RATE || exit 1
+
+grep -E "^(hostSeconds|simTicks)|packets_received::total" $OUTDIR/stats.txt
@@ -0,0 +1,22 @@
+# Latency vs. injection rate of a 4x4 mesh, for unicast traffic and for
+# 20% row multicasts with and without network multicast, in one gem5 run.
+# The curves are written to $OUTDIR/sweep.csv and $OUTDIR/sweep.json; each
+# curve stops at its first saturated point.
+GEM5=${GEM5:-../build/NULL/gem5.opt}
+OUTDIR=${OUTDIR:-synthetic-sweep}
+
+$GEM5 \
+	--outdir=$OUTDIR \
+	../configs/example/garnet_synth_traffic.py \
+	--network=garnet \
+	--num-cpus=16 \
+	--num-dirs=16 \
+	--topology=Mesh_XY \
+	--mesh-rows=4 \
+	--synthetic=uniform_random \
+	--multicast-pattern=row \
+	--sweep-rates=0.02:0.40:0.02 \
+	--sweep-multicast-probs=0,20 \
+	--sweep-network-multicast=both || exit 1
+
+cat $OUTDIR/sweep.csv
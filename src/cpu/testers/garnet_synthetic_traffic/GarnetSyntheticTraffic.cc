@@ -28,6 +28,7 @@
 
 #include "cpu/testers/garnet_synthetic_traffic/GarnetSyntheticTraffic.hh"
 
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <set>
@@ -92,7 +93,9 @@ GarnetSyntheticTraffic::GarnetSyntheticTraffic(const Params &p)
       precision(p.precision),
       responseLimit(p.response_limit),
       multicstProb(p.multicast_prob),
-      requestorId(p.system->getRequestorId(this))
+      requestorId(p.system->getRequestorId(this)),
+      numPacketsOutstanding(0),
+      stats(this)
 {
     // set up counters
     noResponseCycles = 0;
@@ -105,10 +108,103 @@ GarnetSyntheticTraffic::GarnetSyntheticTraffic(const Params &p)
     traffic = trafficStringToEnum[trafficType];
 
     id = TESTER_NETWORK++;
+    initMulticastPattern(p);
+    rng.init(id);
     DPRINTF(GarnetSyntheticTraffic,"Config Created: Name = %s , and id = %d\n",
             name(), id);
 }
 
+GarnetSyntheticTraffic::TesterStats::TesterStats(statistics::Group *parent)
+    : statistics::Group(parent),
+      ADD_STAT(packets, statistics::units::Count::get(),
+               "packets generated"),
+      ADD_STAT(multicastPackets, statistics::units::Count::get(),
+               "multicast packets generated"),
+      ADD_STAT(deliveries, statistics::units::Count::get(),
+               "packets delivered to a destination"),
+      ADD_STAT(completedPackets, statistics::units::Count::get(),
+               "packets delivered to all of their destinations"),
+      ADD_STAT(completedMulticastPackets, statistics::units::Count::get(),
+               "multicast packets delivered to all of their destinations"),
+      ADD_STAT(multicastFanOut, statistics::units::Count::get(),
+               "destinations of the multicast packets"),
+      ADD_STAT(deliveryLatency, statistics::units::Cycle::get(),
+               "latency from generation to delivery at a destination"),
+      ADD_STAT(completionLatency, statistics::units::Cycle::get(),
+               "latency from generation to delivery at all destinations"),
+      ADD_STAT(multicastCompletionLatency, statistics::units::Cycle::get(),
+               "latency from generation to delivery at all destinations "
+               "of the multicast packets")
+{
+    multicastFanOut.init(16);
+    deliveryLatency.init(32);
+    completionLatency.init(32);
+    multicastCompletionLatency.init(32);
+}
+
+void
+GarnetSyntheticTraffic::initMulticastPattern(const Params &p)
+{
+    std::map<std::string, MulticastPattern> patterns = {
+        {"none", MULTICAST_NONE_},
+        {"broadcast", MULTICAST_BROADCAST_},
+        {"row", MULTICAST_ROW_},
+        {"column", MULTICAST_COLUMN_},
+        {"nearest", MULTICAST_NEAREST_},
+        {"sharers", MULTICAST_SHARERS_},
+    };
+    fatal_if(patterns.count(p.multicast_pattern) == 0,
+             "Unknown multicast pattern: %s!\n", p.multicast_pattern);
+    multicastPattern = patterns[p.multicast_pattern];
+
+    int radix = (int) sqrt(numDestinations);
+    fatal_if((multicastPattern == MULTICAST_ROW_ ||
+              multicastPattern == MULTICAST_COLUMN_ ||
+              multicastPattern == MULTICAST_NEAREST_) &&
+             radix * radix != numDestinations,
+             "The %s multicast pattern needs a square mesh of "
+             "destinations (found %d).\n", p.multicast_pattern,
+             numDestinations);
+
+    if (multicastPattern == MULTICAST_NEAREST_) {
+        fatal_if(p.multicast_fan_out < 1 ||
+                 p.multicast_fan_out >= numDestinations,
+                 "multicast_fan_out must be in [1, %d).\n",
+                 numDestinations);
+
+        // Closest first; ties go to the lowest destination
+        auto distance = [this, radix](unsigned dest) {
+            return std::abs((int) dest % radix - id % radix) +
+                   std::abs((int) dest / radix - id / radix);
+        };
+        for (int dest = 0; dest < numDestinations; dest++) {
+            if (dest != id)
+                nearestDests.push_back(dest);
+        }
+        std::stable_sort(nearestDests.begin(), nearestDests.end(),
+            [&distance](unsigned a, unsigned b) {
+                return distance(a) < distance(b);
+            });
+        nearestDests.resize(p.multicast_fan_out);
+    }
+
+    if (multicastPattern == MULTICAST_SHARERS_) {
+        fatal_if(p.sharer_distribution.empty() ||
+                 (int) p.sharer_distribution.size() >= numDestinations,
+                 "sharer_distribution must cover 1 to %d sharers.\n",
+                 numDestinations - 1);
+        double total = 0;
+        for (double freq : p.sharer_distribution) {
+            fatal_if(freq < 0, "sharer_distribution must not be "
+                     "negative.\n");
+            total += freq;
+            sharerCdf.push_back(total);
+        }
+        fatal_if(total <= 0, "sharer_distribution must not be all "
+                 "zeros.\n");
+    }
+}
+
 Port &
 GarnetSyntheticTraffic::getPort(const std::string &if_name, PortID idx)
 {
@@ -125,6 +221,38 @@ GarnetSyntheticTraffic::init()
 }
 
 
+// The traffic of a restored tester continues where the checkpointed one
+// stopped: same random stream, same packet budget, same tick phase
+void
+GarnetSyntheticTraffic::serialize(CheckpointOut &cp) const
+{
+    panic_if(retryPkt, "%s: checkpoint with a packet waiting for a "
+             "retry.", name());
+
+    Tick next_tick = tickEvent.scheduled() ? tickEvent.when() : MaxTick;
+    SERIALIZE_SCALAR(next_tick);
+    SERIALIZE_SCALAR(numPacketsSent);
+    SERIALIZE_SCALAR(noResponseCycles);
+    rng.serializeSection(cp, "rng");
+}
+
+void
+GarnetSyntheticTraffic::unserialize(CheckpointIn &cp)
+{
+    Tick next_tick;
+    UNSERIALIZE_SCALAR(next_tick);
+    UNSERIALIZE_SCALAR(numPacketsSent);
+    UNSERIALIZE_SCALAR(noResponseCycles);
+    rng.unserializeSection(cp, "rng");
+
+    if (next_tick == MaxTick) {
+        if (tickEvent.scheduled())
+            deschedule(tickEvent);
+    } else {
+        reschedule(tickEvent, next_tick, true);
+    }
+}
+
 void
 GarnetSyntheticTraffic::completeRequest(PacketPtr pkt)
 {
@@ -135,10 +263,86 @@ GarnetSyntheticTraffic::completeRequest(PacketPtr pkt)
 
     assert(pkt->isResponse());
     noResponseCycles = 0;
+    delete pkt->popSenderState();
     delete pkt;
 }
 
 
+void
+GarnetSyntheticTraffic::recordDelivery(Tick latency, bool last,
+                                       bool multicast)
+{
+    std::lock_guard<std::mutex> lock(deliveryMutex);
+
+    Cycles cycles = ticksToCycles(latency);
+    stats.deliveries++;
+    stats.deliveryLatency.sample(cycles);
+    if (!last)
+        return;
+
+    numPacketsOutstanding--;
+    stats.completedPackets++;
+    stats.completionLatency.sample(cycles);
+    if (multicast) {
+        stats.completedMulticastPackets++;
+        stats.multicastCompletionLatency.sample(cycles);
+    }
+}
+
+int
+GarnetSyntheticTraffic::outstandingPackets()
+{
+    std::lock_guard<std::mutex> lock(deliveryMutex);
+    return numPacketsOutstanding;
+}
+
+std::vector<unsigned>
+GarnetSyntheticTraffic::pickMulticastGroup()
+{
+    int radix = (int) sqrt(numDestinations);
+    int src_x = id%radix;
+    int src_y = id/radix;
+    std::vector<unsigned> group;
+
+    if (multicastPattern == MULTICAST_BROADCAST_) {
+        for (int dest = 0; dest < numDestinations; dest++) {
+            if (dest != id)
+                group.push_back(dest);
+        }
+    } else if (multicastPattern == MULTICAST_ROW_) {
+        for (int x = 0; x < radix; x++) {
+            if (x != src_x)
+                group.push_back(src_y*radix + x);
+        }
+    } else if (multicastPattern == MULTICAST_COLUMN_) {
+        for (int y = 0; y < radix; y++) {
+            if (y != src_y)
+                group.push_back(y*radix + src_x);
+        }
+    } else if (multicastPattern == MULTICAST_NEAREST_) {
+        group = nearestDests;
+    } else if (multicastPattern == MULTICAST_SHARERS_) {
+        // Draw the number of sharers, then the sharers among the other
+        // destinations
+        double draw = rng.random<double>() * sharerCdf.back();
+        int num_sharers = 1 + (std::upper_bound(sharerCdf.begin(),
+            sharerCdf.end(), draw) - sharerCdf.begin());
+        num_sharers = std::min(num_sharers, (int) sharerCdf.size());
+
+        std::vector<unsigned> others;
+        for (int dest = 0; dest < numDestinations; dest++) {
+            if (dest != id)
+                others.push_back(dest);
+        }
+        for (int i = 0; i < num_sharers; i++) {
+            int j = rng.random<int>(i, others.size() - 1);
+            std::swap(others[i], others[j]);
+            group.push_back(others[i]);
+        }
+    }
+    return group;
+}
+
 void
 GarnetSyntheticTraffic::tick()
 {
@@ -152,7 +356,7 @@ GarnetSyntheticTraffic::tick()
     // - send pkt if this number is < injRate*(10^precision)
     bool sendAllowedThisCycle;
     double injRange = pow((double) 10, (double) precision);
-    unsigned trySending = random_mt.random<unsigned>(0, (int) injRange);
+    unsigned trySending = rng.random<unsigned>(0, (int) injRange);
     if (trySending < injRate*injRange)
         sendAllowedThisCycle = true;
     else
@@ -197,7 +401,7 @@ GarnetSyntheticTraffic::generatePkt()
     {
         destination = singleDest;
     } else if (traffic == UNIFORM_RANDOM_) {
-        destination = random_mt.random<unsigned>(0, num_destinations - 1);
+        destination = rng.random<unsigned>(0, num_destinations - 1);
     } else if (traffic == BIT_COMPLEMENT_) {
         dest_x = radix - src_x - 1;
         dest_y = radix - src_y - 1;
@@ -282,17 +486,31 @@ GarnetSyntheticTraffic::generatePkt()
     // Vnet 0 and 1 are for control packets (1-flit)
     // Vnet 2 is for data packets (5-flit)
     int injReqType = injVnet;
+    bool multicast = false;
 
     if (injReqType < 0 || injReqType > 2)
     {
-        int rand_num = random_mt.random<unsigned>(0, 100);
+        int rand_num = rng.random<unsigned>(0, 100);
         if(rand_num < multicstProb){
             injReqType = 0;
+            multicast = (multicastPattern != MULTICAST_NONE_);
         }
         else{
             // randomly inject in any vnet
-            injReqType = random_mt.random(1, 2);
+            injReqType = rng.random(1, 2);
         }
+    } else if (multicastPattern != MULTICAST_NONE_) {
+        multicast = (rng.random<unsigned>(0, 100) < multicstProb);
+    }
+
+    // Multicast packets carry their destinations; the address still
+    // names one of them
+    std::vector<unsigned> group;
+    if (multicast)
+        group = pickMulticastGroup();
+    if (!group.empty()) {
+        destination = group[0];
+        paddr = (Addr) destination << blockSizeBits;
     }
 
     if (injReqType == 0) {
@@ -325,7 +543,27 @@ GarnetSyntheticTraffic::generatePkt()
 
     PacketPtr pkt = new Packet(req, requestType);
     pkt->dataDynamic(new uint8_t[req->getSize()]);
-    pkt->senderState = NULL;
+
+    // Track the delivery of the packet to each of its destinations
+    bool is_multicast = !group.empty();
+    auto *state = new ruby::DeliverySenderState;
+    state->destinations.assign(group.begin(), group.end());
+    state->tracker = ruby::DeliveryTracker(
+        is_multicast ? group.size() : 1,
+        [this, is_multicast](Tick latency, bool last) {
+            recordDelivery(latency, last, is_multicast);
+        });
+    pkt->pushSenderState(state);
+
+    {
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+        numPacketsOutstanding++;
+    }
+    stats.packets++;
+    if (is_multicast) {
+        stats.multicastPackets++;
+        stats.multicastFanOut.sample(group.size());
+    }
 
     sendPkt(pkt);
 }
@@ -29,10 +29,14 @@
 #ifndef __CPU_GARNET_SYNTHETIC_TRAFFIC_HH__
 #define __CPU_GARNET_SYNTHETIC_TRAFFIC_HH__
 
+#include <mutex>
 #include <set>
+#include <vector>
 
+#include "base/random.hh"
 #include "base/statistics.hh"
 #include "mem/port.hh"
+#include "mem/ruby/common/DeliveryTracker.hh"
 #include "params/GarnetSyntheticTraffic.hh"
 #include "sim/clocked_object.hh"
 #include "sim/eventq.hh"
@@ -53,6 +57,14 @@ enum TrafficType {BIT_COMPLEMENT_ = 0,
                   UNIFORM_RANDOM_ = 7,
                   NUM_TRAFFIC_PATTERNS_};
 
+enum MulticastPattern {MULTICAST_NONE_ = 0,
+                       MULTICAST_BROADCAST_ = 1,
+                       MULTICAST_ROW_ = 2,
+                       MULTICAST_COLUMN_ = 3,
+                       MULTICAST_NEAREST_ = 4,
+                       MULTICAST_SHARERS_ = 5,
+                       NUM_MULTICAST_PATTERNS_};
+
 class Packet;
 class GarnetSyntheticTraffic : public ClockedObject
 {
@@ -62,6 +74,9 @@ class GarnetSyntheticTraffic : public ClockedObject
 
     void init() override;
 
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
     // main simulation loop (one cycle)
     void tick();
 
@@ -74,6 +89,13 @@ class GarnetSyntheticTraffic : public ClockedObject
      */
     void printAddr(Addr a);
 
+    // Change the traffic between the points of a sweep
+    void setInjectionRate(double rate) { injRate = rate; }
+    void setMulticastProb(int prob) { multicstProb = prob; }
+
+    // Packets generated but not yet delivered to all their destinations
+    int outstandingPackets();
+
   protected:
     EventFunctionWrapper tickEvent;
 
@@ -112,6 +134,10 @@ class GarnetSyntheticTraffic : public ClockedObject
     unsigned size;
     int id;
 
+    // Private generator, so that the traffic of each tester does not
+    // depend on the event queue it runs on
+    Random rng;
+
     std::map<std::string, TrafficType> trafficStringToEnum;
 
     unsigned blockSizeBits;
@@ -136,9 +162,38 @@ class GarnetSyntheticTraffic : public ClockedObject
     // Multicast Probability
     int multicstProb;
 
+    MulticastPattern multicastPattern;
+    // Destinations in the nearest pattern, closest first
+    std::vector<unsigned> nearestDests;
+    // Cumulative frequency of the number of sharers
+    std::vector<double> sharerCdf;
+
     RequestorID requestorId;
 
+    // Deliveries are reported from the event queues of the destinations
+    std::mutex deliveryMutex;
+    int numPacketsOutstanding;
+
+    struct TesterStats : public statistics::Group
+    {
+        TesterStats(statistics::Group *parent);
+
+        statistics::Scalar packets;
+        statistics::Scalar multicastPackets;
+        statistics::Scalar deliveries;
+        statistics::Scalar completedPackets;
+        statistics::Scalar completedMulticastPackets;
+        statistics::Histogram multicastFanOut;
+        statistics::Histogram deliveryLatency;
+        statistics::Histogram completionLatency;
+        statistics::Histogram multicastCompletionLatency;
+    } stats;
+
     void completeRequest(PacketPtr pkt);
+    void recordDelivery(Tick latency, bool last, bool multicast);
+
+    void initMulticastPattern(const Params &p);
+    std::vector<unsigned> pickMulticastGroup();
 
     void generatePkt();
     void sendPkt(PacketPtr pkt);
@@ -27,6 +27,7 @@
 from m5.objects.ClockedObject import ClockedObject
 from m5.params import *
 from m5.proxy import *
+from m5.SimObject import *
 
 
 class GarnetSyntheticTraffic(ClockedObject):
@@ -36,10 +37,17 @@ class GarnetSyntheticTraffic(ClockedObject):
     )
     cxx_class = "gem5::GarnetSyntheticTraffic"
 
+    # Let a sweep change the traffic between its points
+    cxx_exports = [
+        PyBindMethod("setInjectionRate"),
+        PyBindMethod("setMulticastProb"),
+        PyBindMethod("outstandingPackets"),
+    ]
+
     block_offset = Param.Int(6, "block offset in bits")
     num_dest = Param.Int(1, "Number of Destinations")
     memory_size = Param.Int(65536, "memory size")
-    sim_cycles = Param.Int(1000, "Number of simulation cycles")
+    sim_cycles = Param.Tick(1000, "Number of simulation cycles")
     num_packets_max = Param.Int(
         -1,
         "Max number of packets to send. \
@@ -76,3 +84,18 @@ class GarnetSyntheticTraffic(ClockedObject):
     test = RequestPort("Port to the memory system to test")
     system = Param.System(Parent.any, "System we belong to")
     multicast_prob = Param.Int("Probability of Multicast messages")
+    multicast_pattern = Param.String(
+        "none",
+        "destinations of the multicast packets: none (the network picks "
+        "them), broadcast, row, column, nearest or sharers. The tester "
+        "tracks the delivery of its packets to every destination, so the "
+        "network must not expand the destinations further",
+    )
+    multicast_fan_out = Param.Int(
+        4, "destinations of a multicast packet in the nearest pattern"
+    )
+    sharer_distribution = VectorParam.Float(
+        [1.0],
+        "relative frequency of 1, 2, 3, ... destinations of a multicast "
+        "packet in the sharers pattern",
+    )
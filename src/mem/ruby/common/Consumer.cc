@@ -40,6 +40,10 @@
 
 #include "mem/ruby/common/Consumer.hh"
 
+#include <algorithm>
+
+#include "base/bitfield.hh"
+
 namespace gem5
 {
 
@@ -47,7 +51,8 @@ namespace ruby
 {
 
 Consumer::Consumer(ClockedObject *_em, Event::Priority ev_prio)
-    : m_wakeup_event([this]{ processCurrentEvent(); },
+    : m_near_wakeups(0), m_near_base(0), m_near_period(0),
+      m_wakeup_event([this]{ processCurrentEvent(); },
                     "Consumer Event", false, ev_prio),
       em(_em)
 { }
@@ -55,25 +60,80 @@ Consumer::Consumer(ClockedObject *_em, Event::Priority ev_prio)
 void
 Consumer::scheduleEvent(Cycles timeDelta)
 {
-    m_wakeup_ticks.insert(em->clockEdge(timeDelta));
+    insertWakeup(em->clockEdge(timeDelta));
     scheduleNextWakeup();
 }
 
 void
 Consumer::scheduleEventAbsolute(Tick evt_time)
 {
-    m_wakeup_ticks.insert(
-        divCeil(evt_time, em->clockPeriod()) * em->clockPeriod());
+    insertWakeup(divCeil(evt_time, em->clockPeriod()) * em->clockPeriod());
     scheduleNextWakeup();
 }
 
+void
+Consumer::insertWakeup(Tick time)
+{
+    advanceNearWakeups();
+
+    int idx = nearIndex(time);
+    if (idx < 0) {
+        m_far_wakeup_ticks.insert(time);
+    } else if (m_far_wakeup_ticks.empty() ||
+               m_far_wakeup_ticks.find(time) == m_far_wakeup_ticks.end()) {
+        // the tick may have been put in the far set before the bitmap
+        // moved up to it
+        m_near_wakeups |= uint64_t(1) << idx;
+    }
+}
+
+// Move the bitmap up to the current clock edge. The bits of the edges
+// that have passed are shifted out.
+void
+Consumer::advanceNearWakeups()
+{
+    Tick now = em->clockEdge();
+    if (now == m_near_base)
+        return;
+
+    Tick period = em->clockPeriod();
+    if (period != m_near_period || now < m_near_base ||
+        (now - m_near_base) % period != 0) {
+        // The clock changed, the bits no longer map to clock edges
+        spillNearWakeups();
+        m_near_period = period;
+    } else {
+        Tick shift = (now - m_near_base) / period;
+        m_near_wakeups = shift < NEAR_CYCLES ? m_near_wakeups >> shift : 0;
+    }
+    m_near_base = now;
+}
+
+void
+Consumer::spillNearWakeups()
+{
+    while (m_near_wakeups) {
+        int idx = findLsbSet(m_near_wakeups);
+        m_far_wakeup_ticks.insert(m_near_base + idx * m_near_period);
+        m_near_wakeups &= ~(uint64_t(1) << idx);
+    }
+}
+
 void
 Consumer::scheduleNextWakeup()
 {
+    advanceNearWakeups();
+
     // look for the next tick in the future to schedule
-    auto it = m_wakeup_ticks.lower_bound(em->clockEdge());
-    if (it != m_wakeup_ticks.end()) {
-        Tick when = *it;
+    Tick when = MaxTick;
+    if (m_near_wakeups) {
+        when = m_near_base + findLsbSet(m_near_wakeups) * m_near_period;
+    }
+    auto it = m_far_wakeup_ticks.lower_bound(em->clockEdge());
+    if (it != m_far_wakeup_ticks.end())
+        when = std::min(when, *it);
+
+    if (when != MaxTick) {
         assert(when >= em->clockEdge());
         if (m_wakeup_event.scheduled() && (when < m_wakeup_event.when()))
             em->reschedule(m_wakeup_event, when, true);
@@ -85,12 +145,19 @@ Consumer::scheduleNextWakeup()
 void
 Consumer::processCurrentEvent()
 {
-    auto curr = m_wakeup_ticks.begin();
-    assert(em->clockEdge() == *curr);
+    advanceNearWakeups();
 
     // remove the current tick from the wakeup list, wake up, and then schedule
     // the next wakeup
-    m_wakeup_ticks.erase(curr);
+    [[maybe_unused]] bool near = m_near_wakeups & 1;
+    m_near_wakeups &= ~uint64_t(1);
+
+    auto curr = m_far_wakeup_ticks.begin();
+    bool far = curr != m_far_wakeup_ticks.end() && *curr == em->clockEdge();
+    if (far)
+        m_far_wakeup_ticks.erase(curr);
+
+    assert(near || far);
     wakeup();
     scheduleNextWakeup();
 }
@@ -47,6 +47,7 @@
 #ifndef __MEM_RUBY_COMMON_CONSUMER_HH__
 #define __MEM_RUBY_COMMON_CONSUMER_HH__
 
+#include <cstdint>
 #include <iostream>
 #include <set>
 
@@ -75,7 +76,10 @@ class Consumer
     bool
     alreadyScheduled(Tick time)
     {
-        return m_wakeup_ticks.find(time) != m_wakeup_ticks.end();
+        int idx = nearIndex(time);
+        if (idx >= 0 && (m_near_wakeups & (uint64_t(1) << idx)))
+            return true;
+        return m_far_wakeup_ticks.find(time) != m_far_wakeup_ticks.end();
     }
 
     ClockedObject *
@@ -88,10 +92,38 @@ class Consumer
     void scheduleEvent(Cycles timeDelta);
 
   private:
-    std::set<Tick> m_wakeup_ticks;
+    // The wakeups in the NEAR_CYCLES cycles starting at m_near_base are
+    // kept as a bitmap, bit i standing for m_near_base + i * m_near_period.
+    // Almost all wakeups are a few cycles ahead, so this avoids a tree
+    // insert and erase per wakeup. The other wakeups are kept in
+    // m_far_wakeup_ticks.
+    static const int NEAR_CYCLES = 64;
+    uint64_t m_near_wakeups;
+    Tick m_near_base;
+    Tick m_near_period;
+    std::set<Tick> m_far_wakeup_ticks;
+
     EventFunctionWrapper m_wakeup_event;
     ClockedObject *em;
 
+    // Bit of the tick in the bitmap, or -1 if the tick is not in it
+    int
+    nearIndex(Tick time) const
+    {
+        if (time < m_near_base || m_near_period == 0)
+            return -1;
+        Tick delta = time - m_near_base;
+        if (delta % m_near_period != 0 ||
+            delta / m_near_period >= NEAR_CYCLES) {
+            return -1;
+        }
+        return delta / m_near_period;
+    }
+
+    void insertWakeup(Tick time);
+    void advanceNearWakeups();
+    void spillNearWakeups();
+
     void scheduleNextWakeup();
     void processCurrentEvent();
 };
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mem/ruby/common/DeliveryTracker.hh"
+
+#include <cassert>
+
+#include "sim/cur_tick.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+DeliveryTracker::DeliveryTracker(int num_dests, Callback callback)
+    : m_state(std::make_shared<State>())
+{
+    assert(num_dests > 0);
+    m_state->pending = num_dests;
+    m_state->issue_time = curTick();
+    m_state->callback = std::move(callback);
+}
+
+void
+DeliveryTracker::deliver() const
+{
+    if (!m_state)
+        return;
+
+    // Deliveries beyond the expected ones are not reported
+    int pending = --m_state->pending;
+    if (pending >= 0)
+        m_state->callback(curTick() - m_state->issue_time, pending == 0);
+}
+
+void
+DeliveryTracker::print(std::ostream &out) const
+{
+    if (m_state)
+        out << "[DeliveryTracker pending=" << m_state->pending.load()
+            << "]";
+    else
+        out << "[DeliveryTracker none]";
+}
+
+} // namespace ruby
+} // namespace gem5
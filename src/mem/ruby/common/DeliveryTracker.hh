@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MEM_RUBY_COMMON_DELIVERYTRACKER_HH__
+#define __MEM_RUBY_COMMON_DELIVERYTRACKER_HH__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "base/types.hh"
+#include "mem/packet.hh"
+#include "mem/ruby/common/TypeDefines.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+/**
+ * Follows a message to all of its destinations. The copies of the
+ * message share the tracker; each destination calls deliver() when it
+ * receives its copy, and the owner is called back with the latency of
+ * the delivery and whether it was the last one. The destinations may
+ * run on different event queues, so the callback must be thread safe.
+ * A default-constructed tracker tracks nothing.
+ */
+class DeliveryTracker
+{
+  public:
+    typedef std::function<void(Tick latency, bool last)> Callback;
+
+    DeliveryTracker() = default;
+    DeliveryTracker(int num_dests, Callback callback);
+
+    bool valid() const { return m_state != nullptr; }
+
+    void deliver() const;
+
+    void print(std::ostream &out) const;
+
+  private:
+    struct State
+    {
+        std::atomic<int> pending;
+        Tick issue_time;
+        Callback callback;
+    };
+
+    std::shared_ptr<State> m_state;
+};
+
+inline std::ostream &
+operator<<(std::ostream &out, const DeliveryTracker &obj)
+{
+    obj.print(out);
+    return out;
+}
+
+/**
+ * Sender state with which a traffic generator picks the destinations of
+ * the message its packet turns into, and tracks their delivery. The
+ * destinations are machine numbers of the machine type the protocol
+ * sends the message to; when there are none, the protocol picks the
+ * destination as usual.
+ */
+struct DeliverySenderState : public Packet::SenderState
+{
+    std::vector<NodeID> destinations;
+    DeliveryTracker tracker;
+};
+
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_COMMON_DELIVERYTRACKER_HH__
@@ -30,6 +30,8 @@
 
 #include <algorithm>
 
+#include "base/bitfield.hh"
+
 namespace gem5
 {
 
@@ -38,22 +40,25 @@ namespace ruby
 
 NetDest::NetDest()
 {
-  resize();
+    clear();
 }
 
 void
 NetDest::add(MachineID newElement)
 {
-    assert(bitIndex(newElement.num) < m_bits[vecIndex(newElement)].getSize());
-    m_bits[vecIndex(newElement)].add(bitIndex(newElement.num));
+    fatal_if(newElement.num >= NUMBER_BITS_PER_SET,
+             "Number of bits(%d) < size specified(%d). "
+             "Increase the number of bits and recompile.\n",
+             NUMBER_BITS_PER_SET, newElement.num + 1);
+    assert(bitIndex(newElement.num) < MachineType_base_count(newElement.type));
+    m_words[wordIndex(newElement)] |= bit(newElement.num);
 }
 
 void
 NetDest::addNetDest(const NetDest& netDest)
 {
-    assert(m_bits.size() == netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].addSet(netDest.m_bits[i]);
+    for (int i = 0; i < NUM_WORDS; i++) {
+        m_words[i] |= netDest.m_words[i];
     }
 }
 
@@ -63,30 +68,28 @@ NetDest::setNetDest(MachineType machine, const Set& set)
     // assure that there is only one set of destinations for this machine
     assert(MachineType_base_level((MachineType)(machine + 1)) -
            MachineType_base_level(machine) == 1);
-    m_bits[MachineType_base_level(machine)] = set;
+    std::copy(set.m_words, set.m_words + WORDS_PER_TYPE,
+              m_words + MachineType_base_level(machine) * WORDS_PER_TYPE);
 }
 
 void
 NetDest::remove(MachineID oldElement)
 {
-    m_bits[vecIndex(oldElement)].remove(bitIndex(oldElement.num));
+    m_words[wordIndex(oldElement)] &= ~bit(oldElement.num);
 }
 
 void
 NetDest::removeNetDest(const NetDest& netDest)
 {
-    assert(m_bits.size() == netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].removeSet(netDest.m_bits[i]);
+    for (int i = 0; i < NUM_WORDS; i++) {
+        m_words[i] &= ~netDest.m_words[i];
     }
 }
 
 void
 NetDest::clear()
 {
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].clear();
-    }
+    std::fill(m_words, m_words + NUM_WORDS, 0);
 }
 
 void
@@ -107,19 +110,21 @@ NetDest::broadcast(MachineType machineType)
     }
 }
 
+int
+NetDest::nextElement(int start) const
+{
+    return Set::nextSetBit(m_words, NUM_WORDS, start);
+}
+
 //For Princeton Network
 std::vector<NodeID>
 NetDest::getAllDest()
 {
+    const int bits_per_type = WORDS_PER_TYPE * BITS_PER_WORD;
     std::vector<NodeID> dest;
-    dest.clear();
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (int j = 0; j < m_bits[i].getSize(); j++) {
-            if (m_bits[i].isElement(j)) {
-                int id = MachineType_base_number((MachineType)i) + j;
-                dest.push_back((NodeID)id);
-            }
-        }
+    for (int i = nextElement(0); i != -1; i = nextElement(i + 1)) {
+        MachineType type = (MachineType)(i / bits_per_type);
+        dest.push_back(MachineType_base_number(type) + i % bits_per_type);
     }
     return dest;
 }
@@ -127,14 +132,10 @@ NetDest::getAllDest()
 
 MachineType 
 NetDest::getMachineTypeFromNetDest(){
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (int j = 0; j < m_bits[i].getSize(); j++) {
-            if (m_bits[i].isElement(j)) {
-                return (MachineType)i;
-            }
-        }
-    }
-    return MachineType_NUM;
+    int first = nextElement(0);
+    if (first == -1)
+        return MachineType_NUM;
+    return (MachineType)(first / (WORDS_PER_TYPE * BITS_PER_WORD));
 }
 
 
@@ -142,8 +143,8 @@ int
 NetDest::count() const
 {
     int counter = 0;
-    for (int i = 0; i < m_bits.size(); i++) {
-        counter += m_bits[i].count();
+    for (int i = 0; i < NUM_WORDS; i++) {
+        counter += popCount(m_words[i]);
     }
     return counter;
 }
@@ -151,44 +152,45 @@ NetDest::count() const
 NodeID
 NetDest::elementAt(MachineID index)
 {
-    return m_bits[vecIndex(index)].elementAt(bitIndex(index.num));
+    return isElement(index);
 }
 
 MachineID
 NetDest::smallestElement() const
 {
-    assert(count() > 0);
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (NodeID j = 0; j < m_bits[i].getSize(); j++) {
-            if (m_bits[i].isElement(j)) {
-                MachineID mach = {MachineType_from_base_level(i), j};
-                return mach;
-            }
-        }
-    }
-    panic("No smallest element of an empty set.");
+    int first = nextElement(0);
+    if (first == -1)
+        panic("No smallest element of an empty set.");
+    const int bits_per_type = WORDS_PER_TYPE * BITS_PER_WORD;
+    MachineID mach = {MachineType_from_base_level(first / bits_per_type),
+                      (NodeID)(first % bits_per_type)};
+    return mach;
 }
 
 MachineID
 NetDest::smallestElement(MachineType machine) const
 {
-    int size = m_bits[MachineType_base_level(machine)].getSize();
-    for (NodeID j = 0; j < size; j++) {
-        if (m_bits[MachineType_base_level(machine)].isElement(j)) {
-            MachineID mach = {machine, j};
-            return mach;
-        }
-    }
-
-    panic("No smallest element of given MachineType.");
+    const int bits_per_type = WORDS_PER_TYPE * BITS_PER_WORD;
+    int base = MachineType_base_level(machine) * bits_per_type;
+    int element = nextElement(base);
+    if (element == -1 || element >= base + bits_per_type)
+        panic("No smallest element of given MachineType.");
+
+    MachineID mach = {machine, (NodeID)(element - base)};
+    return mach;
 }
 
 // Returns true iff all bits are set
 bool
 NetDest::isBroadcast() const
 {
-    for (int i = 0; i < m_bits.size(); i++) {
-        if (!m_bits[i].isBroadcast()) {
+    const int bits_per_type = WORDS_PER_TYPE * BITS_PER_WORD;
+    int counts[MachineType_NUM] = {};
+    for (int i = nextElement(0); i != -1; i = nextElement(i + 1)) {
+        counts[i / bits_per_type]++;
+    }
+    for (int i = 0; i < MachineType_NUM; i++) {
+        if (counts[i] != MachineType_base_count((MachineType)i)) {
             return false;
         }
     }
@@ -199,8 +201,8 @@ NetDest::isBroadcast() const
 bool
 NetDest::isEmpty() const
 {
-    for (int i = 0; i < m_bits.size(); i++) {
-        if (!m_bits[i].isEmpty()) {
+    for (int i = 0; i < NUM_WORDS; i++) {
+        if (m_words[i]) {
             return false;
         }
     }
@@ -211,10 +213,9 @@ NetDest::isEmpty() const
 NetDest
 NetDest::OR(const NetDest& orNetDest) const
 {
-    assert(m_bits.size() == orNetDest.getSize());
     NetDest result;
-    for (int i = 0; i < m_bits.size(); i++) {
-        result.m_bits[i] = m_bits[i].OR(orNetDest.m_bits[i]);
+    for (int i = 0; i < NUM_WORDS; i++) {
+        result.m_words[i] = m_words[i] | orNetDest.m_words[i];
     }
     return result;
 }
@@ -223,10 +224,9 @@ NetDest::OR(const NetDest& orNetDest) const
 NetDest
 NetDest::AND(const NetDest& andNetDest) const
 {
-    assert(m_bits.size() == andNetDest.getSize());
     NetDest result;
-    for (int i = 0; i < m_bits.size(); i++) {
-        result.m_bits[i] = m_bits[i].AND(andNetDest.m_bits[i]);
+    for (int i = 0; i < NUM_WORDS; i++) {
+        result.m_words[i] = m_words[i] & andNetDest.m_words[i];
     }
     return result;
 }
@@ -235,9 +235,8 @@ NetDest::AND(const NetDest& andNetDest) const
 bool
 NetDest::intersectionIsNotEmpty(const NetDest& other_netDest) const
 {
-    assert(m_bits.size() == other_netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
-        if (!m_bits[i].intersectionIsEmpty(other_netDest.m_bits[i])) {
+    for (int i = 0; i < NUM_WORDS; i++) {
+        if (m_words[i] & other_netDest.m_words[i]) {
             return true;
         }
     }
@@ -247,10 +246,8 @@ NetDest::intersectionIsNotEmpty(const NetDest& other_netDest) const
 bool
 NetDest::isSuperset(const NetDest& test) const
 {
-    assert(m_bits.size() == test.getSize());
-
-    for (int i = 0; i < m_bits.size(); i++) {
-        if (!m_bits[i].isSuperset(test.m_bits[i])) {
+    for (int i = 0; i < NUM_WORDS; i++) {
+        if (test.m_words[i] & ~m_words[i]) {
             return false;
         }
     }
@@ -260,28 +257,26 @@ NetDest::isSuperset(const NetDest& test) const
 bool
 NetDest::isElement(MachineID element) const
 {
-    return ((m_bits[vecIndex(element)])).isElement(bitIndex(element.num));
+    return m_words[wordIndex(element)] & bit(element.num);
 }
 
 void
 NetDest::resize()
 {
-    m_bits.resize(MachineType_base_level(MachineType_NUM));
-    assert(m_bits.size() == MachineType_NUM);
-
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].setSize(MachineType_base_count((MachineType)i));
-    }
+    // The storage covers every machine type; only clear it
+    clear();
 }
 
 void
 NetDest::print(std::ostream& out) const
 {
-    out << "[NetDest (" << m_bits.size() << ") ";
+    out << "[NetDest (" << MachineType_NUM << ") ";
 
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (int j = 0; j < m_bits[i].getSize(); j++) {
-            out << (bool) m_bits[i].isElement(j) << " ";
+    for (int i = 0; i < MachineType_NUM; i++) {
+        MachineType type = (MachineType)i;
+        for (NodeID j = 0; j < MachineType_base_count(type); j++) {
+            MachineID mach = {type, j};
+            out << (bool) isElement(mach) << " ";
         }
         out << " - ";
     }
@@ -291,12 +286,7 @@ NetDest::print(std::ostream& out) const
 bool
 NetDest::isEqual(const NetDest& n) const
 {
-    assert(m_bits.size() == n.m_bits.size());
-    for (unsigned int i = 0; i < m_bits.size(); ++i) {
-        if (!m_bits[i].isEqual(n.m_bits[i]))
-            return false;
-    }
-    return true;
+    return std::equal(m_words, m_words + NUM_WORDS, n.m_words);
 }
 
 } // namespace ruby
@@ -29,6 +29,7 @@
 #ifndef __MEM_RUBY_COMMON_NETDEST_HH__
 #define __MEM_RUBY_COMMON_NETDEST_HH__
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -41,7 +42,12 @@ namespace gem5
 namespace ruby
 {
 
-// NetDest specifies the network destination of a Message
+// NetDest specifies the network destination of a Message.
+//
+// The destinations are kept in a single inline array of 64-bit words:
+// Set::NUM_WORDS words per machine type, in MachineType order. Copying a
+// NetDest does not allocate, and the set operations and the iteration
+// over the destinations work a word at a time over the whole array.
 class NetDest
 {
   public:
@@ -76,7 +82,11 @@ class NetDest
     bool intersectionIsNotEmpty(const NetDest& other_netDest) const;
 
     // Returns true if the intersection of the two netDests is empty
-    bool intersectionIsEmpty(const NetDest& other_netDest) const;
+    bool
+    intersectionIsEmpty(const NetDest& other_netDest) const
+    {
+        return !intersectionIsNotEmpty(other_netDest);
+    }
 
     bool isSuperset(const NetDest& test) const;
     bool isSubset(const NetDest& test) const { return test.isSuperset(*this); }
@@ -96,7 +106,7 @@ class NetDest
     MachineID smallestElement(MachineType machine) const;
 
     void resize();
-    int getSize() const { return m_bits.size(); }
+    int getSize() const { return MachineType_NUM; }
 
     // get element for a index
     NodeID elementAt(MachineID index);
@@ -104,20 +114,42 @@ class NetDest
     void print(std::ostream& out) const;
 
   private:
+    static const int BITS_PER_WORD = Set::BITS_PER_WORD;
+    static const int WORDS_PER_TYPE = Set::NUM_WORDS;
+    static const int NUM_WORDS = MachineType_NUM * WORDS_PER_TYPE;
+
     // returns a value >= MachineType_base_level("this machine")
     // and < MachineType_base_level("next highest machine")
     int
     vecIndex(MachineID m) const
     {
         int vec_index = MachineType_base_level(m.type);
-        assert(vec_index < m_bits.size());
+        assert(vec_index < MachineType_NUM);
         return vec_index;
     }
 
     NodeID bitIndex(NodeID index) const { return index; }
 
-    std::vector<Set> m_bits;
-    bool used = false;  // a vector of bit vectors - i.e. Sets
+    // Word holding the given element, and its bit in that word
+    int
+    wordIndex(MachineID m) const
+    {
+        assert(m.num < NUMBER_BITS_PER_SET);
+        return vecIndex(m) * WORDS_PER_TYPE + m.num / BITS_PER_WORD;
+    }
+
+    static uint64_t
+    bit(NodeID index)
+    {
+        return uint64_t(1) << (index % BITS_PER_WORD);
+    }
+
+    // Returns the position of the first destination at or after the
+    // given position in the flat array, or -1 if there is none
+    int nextElement(int start) const;
+
+    uint64_t m_words[NUM_WORDS];
+    bool used = false;
 };
 
 inline std::ostream&
@@ -32,10 +32,11 @@
 #ifndef __MEM_RUBY_COMMON_SET_HH__
 #define __MEM_RUBY_COMMON_SET_HH__
 
-#include <bitset>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 
+#include "base/bitfield.hh"
 #include "base/logging.hh"
 #include "mem/ruby/common/TypeDefines.hh"
 
@@ -45,16 +46,50 @@ namespace gem5
 namespace ruby
 {
 
+class NetDest;
+
+// A set of up to NUMBER_BITS_PER_SET nodes, stored inline as an array of
+// 64-bit words. The set operations work a word at a time and the
+// iteration skips to the next set bit, so that the cost depends on the
+// number of words and elements rather than on NUMBER_BITS_PER_SET.
 class Set
 {
+  public:
+    static const int BITS_PER_WORD = 64;
+    static const int NUM_WORDS =
+        (NUMBER_BITS_PER_SET + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
   private:
     // Number of bits in use in this set.
     // can be defined in build_opts file (default=64).
     int m_nSize;
-    std::bitset<NUMBER_BITS_PER_SET> bits;
+    uint64_t m_words[NUM_WORDS];
+
+    static uint64_t
+    bit(NodeID index)
+    {
+        return uint64_t(1) << (index % BITS_PER_WORD);
+    }
+
+    static uint64_t &
+    word(uint64_t *words, NodeID index)
+    {
+        assert(index < NUMBER_BITS_PER_SET);
+        return words[index / BITS_PER_WORD];
+    }
+
+    static uint64_t
+    word(const uint64_t *words, NodeID index)
+    {
+        assert(index < NUMBER_BITS_PER_SET);
+        return words[index / BITS_PER_WORD];
+    }
+
+    // NetDest lays the sets of all the machine types out in one array
+    friend class NetDest;
 
   public:
-    Set() : m_nSize(0) {}
+    Set() : m_nSize(0) { clear(); }
 
     Set(int size) : m_nSize(size)
     {
@@ -62,22 +97,18 @@ class Set
             fatal("Number of bits(%d) < size specified(%d). "
                   "Increase the number of bits and recompile.\n",
                   NUMBER_BITS_PER_SET, size);
+        clear();
     }
 
-    Set(const Set& obj) : m_nSize(obj.m_nSize), bits(obj.bits) {}
+    Set(const Set& obj) = default;
     ~Set() {}
 
-    Set& operator=(const Set& obj)
-    {
-        m_nSize = obj.m_nSize;
-        bits = obj.bits;
-        return *this;
-    }
+    Set& operator=(const Set& obj) = default;
 
     void
     add(NodeID index)
     {
-        bits.set(index);
+        word(m_words, index) |= bit(index);
     }
 
     /*
@@ -88,7 +119,8 @@ class Set
     addSet(const Set& obj)
     {
         assert(m_nSize == obj.m_nSize);
-        bits |= obj.bits;
+        for (int i = 0; i < NUM_WORDS; i++)
+            m_words[i] |= obj.m_words[i];
     }
 
     /*
@@ -97,7 +129,7 @@ class Set
     void
     remove(NodeID index)
     {
-        bits.reset(index);
+        word(m_words, index) &= ~bit(index);
     }
 
     /*
@@ -107,26 +139,45 @@ class Set
     removeSet(const Set& obj)
     {
         assert(m_nSize == obj.m_nSize);
-        bits &= (~obj.bits);
+        for (int i = 0; i < NUM_WORDS; i++)
+            m_words[i] &= ~obj.m_words[i];
     }
 
-    void clear() { bits.reset(); }
+    void
+    clear()
+    {
+        for (int i = 0; i < NUM_WORDS; i++)
+            m_words[i] = 0;
+    }
 
     /*
      * this function sets all bits in the set
      */
-    void broadcast()
+    void
+    broadcast()
     {
-        bits.set();
-        for (int j = m_nSize; j < NUMBER_BITS_PER_SET; ++j) {
-            bits.reset(j);
+        for (int i = 0; i < NUM_WORDS; i++) {
+            int lo = i * BITS_PER_WORD;
+            if (m_nSize >= lo + BITS_PER_WORD)
+                m_words[i] = ~uint64_t(0);
+            else if (m_nSize > lo)
+                m_words[i] = mask(m_nSize - lo);
+            else
+                m_words[i] = 0;
         }
     }
 
     /*
      * This function returns the population count of 1's in the set
      */
-    int count() const { return bits.count(); }
+    int
+    count() const
+    {
+        int c = 0;
+        for (int i = 0; i < NUM_WORDS; i++)
+            c += popCount(m_words[i]);
+        return c;
+    }
 
     /*
      * This function checks for set equality
@@ -135,7 +186,11 @@ class Set
     isEqual(const Set& obj) const
     {
         assert(m_nSize == obj.m_nSize);
-        return bits == obj.bits;
+        for (int i = 0; i < NUM_WORDS; i++) {
+            if (m_words[i] != obj.m_words[i])
+                return false;
+        }
+        return true;
     }
 
     // return the logical OR of this set and orSet
@@ -144,7 +199,8 @@ class Set
     {
         assert(m_nSize == obj.m_nSize);
         Set r(m_nSize);
-        r.bits = bits | obj.bits;
+        for (int i = 0; i < NUM_WORDS; i++)
+            r.m_words[i] = m_words[i] | obj.m_words[i];
         return r;
     };
 
@@ -154,7 +210,8 @@ class Set
     {
         assert(m_nSize == obj.m_nSize);
         Set r(m_nSize);
-        r.bits = bits & obj.bits;
+        for (int i = 0; i < NUM_WORDS; i++)
+            r.m_words[i] = m_words[i] & obj.m_words[i];
         return r;
     }
 
@@ -162,8 +219,11 @@ class Set
     bool
     intersectionIsEmpty(const Set& obj) const
     {
-        std::bitset<NUMBER_BITS_PER_SET> r = bits & obj.bits;
-        return r.none();
+        for (int i = 0; i < NUM_WORDS; i++) {
+            if (m_words[i] & obj.m_words[i])
+                return false;
+        }
+        return true;
     }
 
     /*
@@ -174,13 +234,20 @@ class Set
     isSuperset(const Set& test) const
     {
         assert(m_nSize == test.m_nSize);
-        std::bitset<NUMBER_BITS_PER_SET> r = bits | test.bits;
-        return (r == bits);
+        for (int i = 0; i < NUM_WORDS; i++) {
+            if (test.m_words[i] & ~m_words[i])
+                return false;
+        }
+        return true;
     }
 
     bool isSubset(const Set& test) const { return test.isSuperset(*this); }
 
-    bool isElement(NodeID element) const { return bits.test(element); }
+    bool
+    isElement(NodeID element) const
+    {
+        return word(m_words, element) & bit(element);
+    }
 
     /*
      * this function returns true iff all bits in use are set
@@ -188,22 +255,57 @@ class Set
     bool
     isBroadcast() const
     {
-        return (bits.count() == m_nSize);
+        return (count() == m_nSize);
     }
 
-    bool isEmpty() const { return bits.none(); }
+    bool
+    isEmpty() const
+    {
+        for (int i = 0; i < NUM_WORDS; i++) {
+            if (m_words[i])
+                return false;
+        }
+        return true;
+    }
+
+    // Returns the smallest element >= start, or -1 if there is none.
+    // Used to iterate over the elements:
+    //   for (int i = s.nextElement(0); i != -1; i = s.nextElement(i + 1))
+    int
+    nextElement(int start) const
+    {
+        return nextSetBit(m_words, NUM_WORDS, start);
+    }
 
-    NodeID smallestElement() const
+    // Returns the smallest bit >= start set in an array of num_words
+    // words, or -1 if there is none. Shared with the other bitmaps built
+    // on the same words (NetDest, garnet's DestMask).
+    static int
+    nextSetBit(const uint64_t *words, int num_words, int start)
     {
-        for (int i = 0; i < m_nSize; ++i) {
-            if (bits.test(i)) {
-                return i;
-            }
+        int w = start / BITS_PER_WORD;
+        if (w >= num_words)
+            return -1;
+        uint64_t bits = words[w] & ~(bit(start) - 1);
+        while (true) {
+            if (bits)
+                return w * BITS_PER_WORD + findLsbSet(bits);
+            if (++w >= num_words)
+                return -1;
+            bits = words[w];
         }
-        panic("No smallest element of an empty set.");
     }
 
-    bool elementAt(int index) const { return bits[index]; }
+    NodeID
+    smallestElement() const
+    {
+        int element = nextElement(0);
+        if (element == -1 || element >= m_nSize)
+            panic("No smallest element of an empty set.");
+        return element;
+    }
+
+    bool elementAt(int index) const { return isElement(index); }
 
     int getSize() const { return m_nSize; }
 
@@ -215,12 +317,17 @@ class Set
                   "Increase the number of bits and recompile.\n",
                   NUMBER_BITS_PER_SET, size);
         m_nSize = size;
-        bits.reset();
+        clear();
     }
 
-    void print(std::ostream& out) const
+    void
+    print(std::ostream& out) const
     {
-        out << "[Set (" << m_nSize << "): " << bits << "]";
+        // Same format as a std::bitset: the highest bit first
+        out << "[Set (" << m_nSize << "): ";
+        for (int i = NUMBER_BITS_PER_SET - 1; i >= 0; i--)
+            out << (isElement(i) ? '1' : '0');
+        out << "]";
     }
 };
 
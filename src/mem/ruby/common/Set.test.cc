@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <bitset>
+#include <random>
+#include <vector>
+
+#include "mem/ruby/common/Set.hh"
+
+using namespace gem5;
+using namespace gem5::ruby;
+
+namespace
+{
+
+// The storage Set used before it was flattened into words
+typedef std::bitset<NUMBER_BITS_PER_SET> Bits;
+
+Bits
+toBits(const Set &s)
+{
+    Bits b;
+    for (int i = 0; i < NUMBER_BITS_PER_SET; i++)
+        b[i] = s.isElement(i);
+    return b;
+}
+
+void
+randomFill(Set &s, Bits &b, std::mt19937 &rng, int size, int num)
+{
+    for (int i = 0; i < num; i++) {
+        int e = rng() % size;
+        s.add(e);
+        b.set(e);
+    }
+}
+
+} // anonymous namespace
+
+TEST(RubySetTest, EmptyOnConstruction)
+{
+    Set s(NUMBER_BITS_PER_SET);
+    EXPECT_TRUE(s.isEmpty());
+    EXPECT_EQ(0, s.count());
+    EXPECT_EQ(-1, s.nextElement(0));
+}
+
+TEST(RubySetTest, MatchesBitset)
+{
+    std::mt19937 rng(1);
+    const int size = NUMBER_BITS_PER_SET;
+    for (int iter = 0; iter < 200; iter++) {
+        Set a(size), b(size);
+        Bits ra, rb;
+        randomFill(a, ra, rng, size, rng() % size);
+        randomFill(b, rb, rng, size, rng() % size);
+
+        EXPECT_EQ(ra.count(), (size_t)a.count());
+        EXPECT_EQ(ra, toBits(a));
+        EXPECT_EQ(ra | rb, toBits(a.OR(b)));
+        EXPECT_EQ(ra & rb, toBits(a.AND(b)));
+        EXPECT_EQ((ra & rb).none(), a.intersectionIsEmpty(b));
+        EXPECT_EQ((ra | rb) == ra, a.isSuperset(b));
+        EXPECT_EQ(ra == rb, a.isEqual(b));
+
+        Set c = a;
+        c.removeSet(b);
+        EXPECT_EQ(ra & ~rb, toBits(c));
+        c.addSet(b);
+        EXPECT_EQ(ra | rb, toBits(c));
+
+        int e = rng() % size;
+        c.remove(e);
+        EXPECT_FALSE(c.isElement(e));
+    }
+}
+
+TEST(RubySetTest, IteratesOverElements)
+{
+    std::mt19937 rng(2);
+    Set s(NUMBER_BITS_PER_SET);
+    Bits b;
+    randomFill(s, b, rng, NUMBER_BITS_PER_SET, NUMBER_BITS_PER_SET / 4);
+
+    std::vector<int> expected;
+    for (int i = 0; i < NUMBER_BITS_PER_SET; i++) {
+        if (b[i])
+            expected.push_back(i);
+    }
+    std::vector<int> visited;
+    for (int i = s.nextElement(0); i != -1; i = s.nextElement(i + 1))
+        visited.push_back(i);
+
+    EXPECT_EQ(expected, visited);
+    EXPECT_EQ(expected.front(), (int)s.smallestElement());
+}
+
+TEST(RubySetTest, BroadcastSetsOnlyTheBitsInUse)
+{
+    for (int size : {1, 7, 63, 64, NUMBER_BITS_PER_SET}) {
+        if (size > NUMBER_BITS_PER_SET)
+            continue;
+        Set s(size);
+        s.broadcast();
+        EXPECT_EQ(size, s.count());
+        EXPECT_TRUE(s.isBroadcast());
+        EXPECT_TRUE(s.isElement(size - 1));
+        if (size < NUMBER_BITS_PER_SET) {
+            EXPECT_FALSE(s.isElement(size));
+        }
+    }
+}
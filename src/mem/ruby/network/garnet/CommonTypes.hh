@@ -31,7 +31,11 @@
 #ifndef __MEM_RUBY_NETWORK_GARNET_0_COMMONTYPES_HH__
 #define __MEM_RUBY_NETWORK_GARNET_0_COMMONTYPES_HH__
 
+#include <cassert>
+#include <vector>
+
 #include "mem/ruby/common/NetDest.hh"
+#include "mem/ruby/network/garnet/DestMask.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
 
 namespace gem5
@@ -52,15 +56,29 @@ enum VNET_type {CTRL_VNET_, DATA_VNET_, NULL_VNET_, NUM_VNET_TYPE_};
 enum flit_stage {I_, VA_, SA_, ST_, LT_, NUM_FLIT_STAGE_};
 enum link_type { EXT_IN_, EXT_OUT_, INT_, NUM_LINK_TYPES_ };
 enum RoutingAlgorithm { TABLE_ = 0, XY_ = 1, CUSTOM_ = 2,
+                        WEST_FIRST_ = 3, ODD_EVEN_ = 4,
                         NUM_ROUTING_ALGORITHM_};
+// The VCs of a vnet a packet may be allocated at the next router.
+// Under adaptive routing the first VC of each vnet is an escape VC,
+// reserved for packets that fall back to XY routing.
+enum VC_class_type { ANY_VC_, ADAPTIVE_VC_, ESCAPE_VC_,
+                     NUM_VC_CLASS_TYPE_ };
+// How the NI sends a message to several destinations: one multicast
+// packet, one unicast packet per destination, or a multicast packet to
+// the clustered destinations and unicast packets to the stragglers.
+enum MulticastPath { MULTICAST_PATH_, UNICAST_PATH_, SPLIT_PATH_,
+                     NUM_MULTICAST_PATH_ };
 
 struct RouteInfo
 {
     RouteInfo()
-        : vnet(0), src_ni(0), src_router(0), dest_ni(0), dest_router(0),
-          hops_traversed(0)
+        : vnet(0), src_ni(0), src_router(0), dest_ni(0), dest_router(0)
     {}
 
+    // A multicast packet is routed on its destination mask alone;
+    // dest_ni and dest_router are only meaningful for unicast packets.
+    bool isMulticast() const { return dest_ni == -1; }
+
     // destination format for table-based routing
     int vnet;
     NetDest net_dest;
@@ -70,21 +88,64 @@ struct RouteInfo
     int src_router;
     int dest_ni;
     int dest_router;
-    int hops_traversed;
 };
 
+// Per-outport branch of a packet held in an input VC: the destinations
+// reached through the outport and the output VC allocated to them.
 struct OutInfo
 {
-    OutInfo()
+    OutInfo() : outvc(-1), vc_class(ANY_VC_) {}
+
+    int outvc;
+    VC_class_type vc_class;
+    DestMask dests;
+};
+
+// The branches of the packet held in an input VC, indexed by outport.
+// The table is sized once for the outports of the router and reused by
+// every packet through the VC, so that neither route computation nor
+// switch allocation allocates or copies. The outports that have a branch
+// are also kept in a dense list to iterate over.
+class OutInfoTable
+{
+  public:
+    void
+    init(int num_outports)
     {
-	outvc = -1;
-	routes = std::vector<RouteInfo>();
-	msg_ptrs = std::vector<MsgPtr>();
+        m_out_info.resize(num_outports);
+        m_outports.reserve(num_outports);
     }
-    
-    int outvc;
-    std::vector<RouteInfo> routes;
-    std::vector<MsgPtr> msg_ptrs;
+
+    void
+    clear()
+    {
+        for (int outport : m_outports)
+            m_out_info[outport] = OutInfo();
+        m_outports.clear();
+    }
+
+    void
+    add(int outport, const DestMask &dests,
+        VC_class_type vc_class = ANY_VC_)
+    {
+        assert(m_out_info[outport].dests.isEmpty());
+        m_out_info[outport].dests = dests;
+        m_out_info[outport].vc_class = vc_class;
+        m_outports.push_back(outport);
+    }
+
+    const std::vector<int> &outports() const { return m_outports; }
+
+    OutInfo &operator[](int outport) { return m_out_info[outport]; }
+    const OutInfo &
+    operator[](int outport) const
+    {
+        return m_out_info[outport];
+    }
+
+  private:
+    std::vector<OutInfo> m_out_info;
+    std::vector<int> m_outports;
 };
 
 
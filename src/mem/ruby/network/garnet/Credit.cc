@@ -46,8 +46,7 @@ namespace garnet
 // and m_is_free_signal (whether VC is free or not)
 
 Credit::Credit(int vc, bool is_free_signal, Tick curTime)
-    : flit(0, 0, vc, 0, std::vector<RouteInfo>(1, RouteInfo()),
-           0, 1, std::vector<MsgPtr>(1, nullptr), 0, 0, curTime)
+    : flit(0, 0, vc, 0, nullptr, DestMask(), 0, 0, 0, curTime)
 {
     m_is_free_signal = is_free_signal;
     m_type = CREDIT_;
@@ -46,7 +46,7 @@ namespace garnet
 
 CrossbarSwitch::CrossbarSwitch(Router *router)
   : Consumer(router), m_router(router), m_num_vcs(m_router->get_num_vcs()),
-    m_crossbar_activity(0), switchBuffers(0)
+    m_crossbar_activity(0), switchBuffers(0), m_num_flits(0)
 {
 }
 
@@ -69,13 +69,17 @@ CrossbarSwitch::wakeup()
             "at time: %lld\n",
             m_router->get_id(), m_router->curCycle());
 
+    if (m_num_flits == 0)
+        return;
+
     for (auto& switch_buffer : switchBuffers) {
-        if (!switch_buffer.isReady(curTick())) {
-            continue;
-        }
+        // A multicast flit may have been granted several outports in the
+        // same cycle, so send out every branch that is ready.
+        while (switch_buffer.isReady(curTick())) {
+            flit *t_flit = switch_buffer.peekTopFlit();
+            if (!t_flit->is_stage(ST_, curTick()))
+                break;
 
-        flit *t_flit = switch_buffer.peekTopFlit();
-        if (t_flit->is_stage(ST_, curTick())) {
             int outport = t_flit->get_outport();
 
             // flit performs LT_ in the next cycle
@@ -86,6 +90,7 @@ CrossbarSwitch::wakeup()
             // in the next cycle
             m_router->getOutputUnit(outport)->insert_flit(t_flit);
             switch_buffer.getTopFlit();
+            m_num_flits--;
             m_crossbar_activity++;
         }
     }
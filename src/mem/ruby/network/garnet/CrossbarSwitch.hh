@@ -63,9 +63,11 @@ class CrossbarSwitch : public Consumer
     update_sw_winner(int inport, flit *t_flit)
     {
         switchBuffers[inport].insert(t_flit);
+        m_num_flits++;
     }
 
     inline double get_crossbar_activity() { return m_crossbar_activity; }
+    inline int get_num_flits() const { return m_num_flits; }
 
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *pkt);
@@ -76,6 +78,8 @@ class CrossbarSwitch : public Consumer
     int m_num_vcs;
     double m_crossbar_activity;
     std::vector<flitBuffer> switchBuffers;
+    // Flits granted by the SwitchAllocator and not yet sent out
+    int m_num_flits;
 };
 
 } // namespace garnet
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_0_DESTMASK_HH__
+#define __MEM_RUBY_NETWORK_GARNET_0_DESTMASK_HH__
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+
+#include "base/bitfield.hh"
+#include "mem/ruby/common/Set.hh"
+#include "mem/ruby/common/TypeDefines.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+// DestMask is the set of destination NIs of a packet, indexed by the
+// local NI id within the network. A multicast packet carries a single
+// DestMask which routers split into per-outport sub-masks as the packet
+// branches out along its multicast tree.
+class DestMask
+{
+  public:
+    // Maximum number of NIs that can be addressed in one network.
+    // NetDest already limits each machine type to NUMBER_BITS_PER_SET
+    // instances, so this leaves room for several machine types.
+    static const int MAX_NIS = 8 * NUMBER_BITS_PER_SET;
+
+    DestMask() { clear(); }
+
+    void
+    add(NodeID ni)
+    {
+        assert(ni < MAX_NIS);
+        m_words[ni / BITS_PER_WORD] |= bit(ni);
+    }
+
+    void
+    remove(NodeID ni)
+    {
+        assert(ni < MAX_NIS);
+        m_words[ni / BITS_PER_WORD] &= ~bit(ni);
+    }
+
+    bool
+    isElement(NodeID ni) const
+    {
+        assert(ni < MAX_NIS);
+        return m_words[ni / BITS_PER_WORD] & bit(ni);
+    }
+
+    void
+    clear()
+    {
+        for (int i = 0; i < NUM_WORDS; i++)
+            m_words[i] = 0;
+    }
+
+    // Set all the bits that are set in the parameter mask
+    void
+    addMask(const DestMask &obj)
+    {
+        for (int i = 0; i < NUM_WORDS; i++)
+            m_words[i] |= obj.m_words[i];
+    }
+
+    // Clear all the bits that are set in the parameter mask
+    void
+    removeMask(const DestMask &obj)
+    {
+        for (int i = 0; i < NUM_WORDS; i++)
+            m_words[i] &= ~obj.m_words[i];
+    }
+
+    // return the logical AND of this mask and the parameter mask
+    DestMask
+    AND(const DestMask &obj) const
+    {
+        DestMask r;
+        for (int i = 0; i < NUM_WORDS; i++)
+            r.m_words[i] = m_words[i] & obj.m_words[i];
+        return r;
+    }
+
+    int
+    count() const
+    {
+        int c = 0;
+        for (int i = 0; i < NUM_WORDS; i++)
+            c += popCount(m_words[i]);
+        return c;
+    }
+
+    bool
+    isEmpty() const
+    {
+        for (int i = 0; i < NUM_WORDS; i++) {
+            if (m_words[i])
+                return false;
+        }
+        return true;
+    }
+
+    bool
+    intersectionIsEmpty(const DestMask &obj) const
+    {
+        for (int i = 0; i < NUM_WORDS; i++) {
+            if (m_words[i] & obj.m_words[i])
+                return false;
+        }
+        return true;
+    }
+
+    bool
+    isEqual(const DestMask &obj) const
+    {
+        for (int i = 0; i < NUM_WORDS; i++) {
+            if (m_words[i] != obj.m_words[i])
+                return false;
+        }
+        return true;
+    }
+
+    // Returns the smallest element >= start, or -1 if there is none.
+    // Used to iterate over the set bits:
+    //   for (int ni = m.nextElement(0); ni != -1; ni = m.nextElement(ni+1))
+    int
+    nextElement(int start) const
+    {
+        return Set::nextSetBit(m_words, NUM_WORDS, start);
+    }
+
+    int smallestElement() const { return nextElement(0); }
+
+    void
+    print(std::ostream& out) const
+    {
+        out << "[DestMask:";
+        for (int ni = nextElement(0); ni != -1; ni = nextElement(ni + 1))
+            out << " " << ni;
+        out << "]";
+    }
+
+  private:
+    static const int BITS_PER_WORD = Set::BITS_PER_WORD;
+    static const int NUM_WORDS =
+        (MAX_NIS + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    static uint64_t
+    bit(int ni)
+    {
+        return uint64_t(1) << (ni % BITS_PER_WORD);
+    }
+
+    uint64_t m_words[NUM_WORDS];
+};
+
+inline std::ostream&
+operator<<(std::ostream& out, const DestMask& obj)
+{
+    obj.print(out);
+    out << std::flush;
+    return out;
+}
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_GARNET_0_DESTMASK_HH__
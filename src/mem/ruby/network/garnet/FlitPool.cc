@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#include "mem/ruby/network/garnet/FlitPool.hh"
+
+#include <algorithm>
+#include <cassert>
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+// Smallest number of slots the pool grows by
+static const int MIN_CHUNK_SIZE = 64;
+
+FlitPool::FlitPool()
+    : m_chunk_size(MIN_CHUNK_SIZE), m_capacity(0), m_hits(0), m_misses(0)
+{
+}
+
+void
+FlitPool::init(int num_flits)
+{
+    m_chunk_size = std::max(num_flits, MIN_CHUNK_SIZE);
+    grow(m_chunk_size);
+}
+
+void
+FlitPool::grow(int num_flits)
+{
+    m_chunks.emplace_back(new Slot[num_flits]);
+    Slot *chunk = m_chunks.back().get();
+
+    m_free_list.reserve(m_capacity + num_flits);
+    for (int i = num_flits - 1; i >= 0; i--) {
+        m_free_list.push_back(&chunk[i]);
+    }
+    m_capacity += num_flits;
+}
+
+void *
+FlitPool::allocate()
+{
+    if (m_free_list.empty()) {
+        m_misses++;
+        grow(m_chunk_size);
+    } else {
+        m_hits++;
+    }
+
+    Slot *slot = m_free_list.back();
+    m_free_list.pop_back();
+    return slot;
+}
+
+void
+FlitPool::release(flit *t_flit)
+{
+    t_flit->~flit();
+    m_free_list.push_back(reinterpret_cast<Slot *>(t_flit));
+}
+
+void
+FlitPool::dispose(flit *t_flit)
+{
+    if (t_flit->m_pool) {
+        t_flit->m_pool->release(t_flit);
+    } else {
+        delete t_flit;
+    }
+}
+
+void
+FlitPool::resetStats()
+{
+    m_hits = 0;
+    m_misses = 0;
+}
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_0_FLITPOOL_HH__
+#define __MEM_RUBY_NETWORK_GARNET_0_FLITPOOL_HH__
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "mem/ruby/network/garnet/flit.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+// FlitPool recycles the storage of the flits of a network. Flits are
+// constructed in place in slots taken from a free list, and their slots
+// are returned to the free list when the flits are destroyed, so that
+// steady-state flit traffic does not go through the heap allocator.
+// The pool grows by whole chunks of slots whenever the free list runs dry.
+class FlitPool
+{
+  public:
+    FlitPool();
+    ~FlitPool() = default;
+
+    // Preallocate num_flits slots; also sets the size of later chunks
+    void init(int num_flits);
+
+    template <typename... Args>
+    flit *
+    create(Args&&... args)
+    {
+        flit *t_flit = new (allocate()) flit(std::forward<Args>(args)...);
+        t_flit->m_pool = this;
+        return t_flit;
+    }
+
+    // Destroy a flit, returning its storage to the pool it came from.
+    // Flits and credits that were not allocated from a pool are deleted.
+    static void dispose(flit *t_flit);
+
+    // Make the storage of a pooled flit return to this pool. Used when a
+    // flit moves to another partition, which has its own pool.
+    void
+    adopt(flit *t_flit)
+    {
+        if (t_flit->m_pool)
+            t_flit->m_pool = this;
+    }
+
+    uint64_t getHits() const { return m_hits; }
+    uint64_t getMisses() const { return m_misses; }
+    int getCapacity() const { return m_capacity; }
+    void resetStats();
+
+  private:
+    struct alignas(flit) Slot
+    {
+        unsigned char bytes[sizeof(flit)];
+    };
+
+    void *allocate();
+    void release(flit *t_flit);
+    void grow(int num_flits);
+
+    std::vector<std::unique_ptr<Slot[]>> m_chunks;
+    std::vector<Slot *> m_free_list;
+    int m_chunk_size;
+    int m_capacity;
+
+    // allocations served from / not served from the free list
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_GARNET_0_FLITPOOL_HH__
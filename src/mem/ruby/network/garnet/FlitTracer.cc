@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mem/ruby/network/garnet/FlitTracer.hh"
+
+#include <cstring>
+#include <utility>
+
+#include "base/logging.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+FlitTracer::FlitTracer(const std::string &file_name, int num_partitions)
+    : m_buffers(num_partitions), m_closing(false)
+{
+    m_stream = simout.create(file_name, true);
+    fatal_if(!m_stream, "Unable to open flit trace file %s\n", file_name);
+
+    FlitTraceHeader header;
+    std::memcpy(header.magic, "GFTR", 4);
+    header.version = 1;
+    header.record_size = sizeof(FlitTraceRecord);
+    header.reserved = 0;
+    m_stream->stream()->write((const char *)&header, sizeof(header));
+
+    for (auto &buffer : m_buffers)
+        buffer.reserve(BUFFER_RECORDS);
+
+    m_writer = std::thread(&FlitTracer::writeLoop, this);
+}
+
+FlitTracer::~FlitTracer()
+{
+    close();
+}
+
+void
+FlitTracer::flush(int partition)
+{
+    std::vector<FlitTraceRecord> &buffer = m_buffers[partition];
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]() {
+        return m_pending.size() < MAX_PENDING_BUFFERS;
+    });
+    m_pending.push_back(std::move(buffer));
+    if (m_spare.empty()) {
+        buffer = std::vector<FlitTraceRecord>();
+    } else {
+        buffer = std::move(m_spare.back());
+        m_spare.pop_back();
+    }
+    lock.unlock();
+    m_cv.notify_all();
+
+    buffer.reserve(BUFFER_RECORDS);
+}
+
+void
+FlitTracer::writeLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_cv.wait(lock, [this]() {
+            return m_closing || !m_pending.empty();
+        });
+        if (m_pending.empty())
+            break;
+
+        std::vector<FlitTraceRecord> buffer = std::move(m_pending.front());
+        m_pending.pop_front();
+        lock.unlock();
+        m_cv.notify_all();
+
+        m_stream->stream()->write((const char *)buffer.data(),
+            buffer.size() * sizeof(FlitTraceRecord));
+        buffer.clear();
+
+        lock.lock();
+        m_spare.push_back(std::move(buffer));
+    }
+}
+
+void
+FlitTracer::close()
+{
+    if (!m_writer.joinable())
+        return;
+
+    for (int i = 0; i < m_buffers.size(); i++) {
+        if (!m_buffers[i].empty())
+            flush(i);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_cv.notify_all();
+    m_writer.join();
+
+    m_stream->stream()->flush();
+    simout.close(m_stream);
+    m_stream = nullptr;
+}
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_0_FLITTRACER_HH__
+#define __MEM_RUBY_NETWORK_GARNET_0_FLITTRACER_HH__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/output.hh"
+#include "mem/ruby/network/garnet/flit.hh"
+#include "sim/cur_tick.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+enum FlitTraceEvent : uint8_t
+{
+    TRACE_ENQUEUE_,     // message handed to the source NI (head flit only)
+    TRACE_INJECT_,      // flit sent out by the source NI
+    TRACE_ROUTER_IN_,   // flit written into an input VC
+    TRACE_ROUTER_OUT_,  // flit granted the switch
+    TRACE_BRANCH_,      // replica of a multicast flit granted the switch
+    TRACE_EJECT_,       // flit received by a destination NI
+    NUM_TRACE_EVENTS_
+};
+
+// The trace file holds a FlitTraceHeader followed by FlitTraceRecords,
+// both in the byte order of the host. util/garnet_flit_trace.py reads it.
+struct FlitTraceHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+};
+
+struct FlitTraceRecord
+{
+    uint64_t tick;
+    uint32_t packet_id;
+    uint16_t flit_id;
+    uint8_t event;
+    uint8_t vnet;
+    uint16_t node;      // router or NI
+    uint8_t inport;     // 0xff if not applicable
+    uint8_t outport;    // 0xff if not applicable
+    uint8_t vc;
+    uint8_t pad;
+    uint16_t dests;     // destinations the flit still has to reach
+};
+
+static_assert(sizeof(FlitTraceRecord) == 24,
+              "the trace format expects 24-byte records");
+
+// FlitTracer records the life of every flit of a network to a binary
+// file. Each partition appends to its own buffer without locking; full
+// buffers are handed to a writer thread, so the simulation only waits for
+// the file when the writer falls several buffers behind.
+class FlitTracer
+{
+  public:
+    FlitTracer(const std::string &file_name, int num_partitions);
+    ~FlitTracer();
+
+    void
+    record(int partition, FlitTraceEvent event, flit *t_flit, int node,
+           int inport, int outport, int vc, Tick tick = curTick())
+    {
+        std::vector<FlitTraceRecord> &buffer = m_buffers[partition];
+        buffer.push_back({tick,
+                          (uint32_t)t_flit->getPacketID(),
+                          (uint16_t)t_flit->get_id(),
+                          event,
+                          (uint8_t)t_flit->get_vnet(),
+                          (uint16_t)node,
+                          (uint8_t)inport,
+                          (uint8_t)outport,
+                          (uint8_t)vc,
+                          0,
+                          (uint16_t)t_flit->get_dest_mask().count()});
+        if (buffer.size() == BUFFER_RECORDS)
+            flush(partition);
+    }
+
+    // Write out all buffered records and stop the writer thread
+    void close();
+
+  private:
+    static constexpr size_t BUFFER_RECORDS = 1 << 16;
+    static constexpr size_t MAX_PENDING_BUFFERS = 8;
+
+    void flush(int partition);
+    void writeLoop();
+
+    OutputStream *m_stream;
+    std::vector<std::vector<FlitTraceRecord>> m_buffers;
+
+    // Shared with the writer thread, protected by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::vector<FlitTraceRecord>> m_pending;
+    std::vector<std::vector<FlitTraceRecord>> m_spare;
+    bool m_closing;
+
+    std::thread m_writer;
+};
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_GARNET_0_FLITTRACER_HH__
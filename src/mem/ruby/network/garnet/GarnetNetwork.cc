@@ -31,7 +31,9 @@
 
 #include "mem/ruby/network/garnet/GarnetNetwork.hh"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 
 #include "base/cast.hh"
 #include "base/compiler.hh"
@@ -40,12 +42,17 @@
 #include "mem/ruby/common/NetDest.hh"
 #include "mem/ruby/network/MessageBuffer.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
+#include "mem/ruby/network/garnet/Credit.hh"
 #include "mem/ruby/network/garnet/CreditLink.hh"
 #include "mem/ruby/network/garnet/GarnetLink.hh"
+#include "mem/ruby/network/garnet/MulticastGroupGenerator.hh"
+#include "mem/ruby/network/garnet/NetworkBridge.hh"
 #include "mem/ruby/network/garnet/NetworkInterface.hh"
 #include "mem/ruby/network/garnet/NetworkLink.hh"
 #include "mem/ruby/network/garnet/Router.hh"
 #include "mem/ruby/system/RubySystem.hh"
+#include "sim/eventq.hh"
+#include "sim/sim_exit.hh"
 
 namespace gem5
 {
@@ -71,8 +78,19 @@ GarnetNetwork::GarnetNetwork(const Params &p)
     m_buffers_per_data_vc = p.buffers_per_data_vc;
     m_buffers_per_ctrl_vc = p.buffers_per_ctrl_vc;
     m_routing_algorithm = p.routing_algorithm;
-    m_next_packet_id = 0;
     m_enable_multicast = p.enable_multicast;
+    m_enable_bypass = p.enable_bypass;
+    m_flit_pool_size = p.flit_pool_size;
+    m_flit_trace_file = p.flit_trace_file;
+    m_multicast_groups = p.multicast_groups;
+    m_partitions = p.partitions;
+    fatal_if(m_partitions < 1, "A network needs at least one partition.");
+
+    // Multicast packets carry their destinations as a DestMask
+    fatal_if(m_nodes > DestMask::MAX_NIS,
+             "Garnet supports at most %d NIs in a network (found %d). "
+             "Increase the NUMBER_BITS_PER_SET and recompile.",
+             DestMask::MAX_NIS, m_nodes);
 
     if (m_enable_multicast)
         DPRINTF(GarnetMulticast, "Multicast enabled.\n");
@@ -124,6 +142,9 @@ GarnetNetwork::init()
         m_nis[i]->addNode(m_toNetQueues[i], m_fromNetQueues[i]);
     }
 
+    if (m_multicast_groups)
+        m_multicast_groups->initStreams(m_nis.size());
+
     // The topology pointer should have already been initialized in the
     // parent network constructor
     assert(m_topology_ptr != NULL);
@@ -142,6 +163,74 @@ GarnetNetwork::init()
         m_num_cols = -1;
     }
 
+    for (auto &router : m_routers) {
+        fatal_if(getPartition(router) >= m_partitions,
+                 "%s is on event queue %d but the network has %d "
+                 "partitions.", router->name(), getPartition(router),
+                 m_partitions);
+    }
+    for (auto &ni : m_nis) {
+        fatal_if(getPartition(ni) >= m_partitions,
+                 "%s is on event queue %d but the network has %d "
+                 "partitions.", ni->name(), getPartition(ni),
+                 m_partitions);
+    }
+
+    // Size the flit pool of each partition to the buffering in its
+    // routers unless configured otherwise
+    std::vector<uint32_t> pool_sizes(m_partitions,
+                                     m_flit_pool_size / m_partitions);
+    if (m_flit_pool_size == 0) {
+        uint32_t buffers_per_vc =
+            std::max(m_buffers_per_data_vc, m_buffers_per_ctrl_vc);
+        for (auto &router : m_routers) {
+            pool_sizes[getPartition(router)] +=
+                router->get_num_inports() * router->get_num_vcs() *
+                buffers_per_vc;
+        }
+    }
+    for (int i = 0; i < m_partitions; i++) {
+        m_flit_pools.emplace_back(new FlitPool());
+        m_flit_pools[i]->init(pool_sizes[i]);
+    }
+
+    if (!m_flit_trace_file.empty()) {
+        m_flit_tracer.reset(new FlitTracer(m_flit_trace_file, m_partitions));
+        registerExitCallback([this]() { m_flit_tracer->close(); });
+    }
+
+    // Links whose consumer is on another partition than the link
+    // itself hand their flits over at the quantum boundaries
+    m_inbound_links.resize(m_partitions);
+    std::vector<NetworkLink *> links(m_networklinks);
+    links.insert(links.end(), m_creditlinks.begin(), m_creditlinks.end());
+    for (auto &link : links) {
+        int src = getPartition(link->getSrcObject());
+        int dst = getPartition(link->getLinkConsumer()->getObject());
+        fatal_if(getPartition(link) != src,
+                 "%s must be on the event queue of its source (%d).",
+                 link->name(), src);
+        if (src == dst)
+            continue;
+
+        fatal_if(link->getLatencyTicks() < simQuantum,
+                 "%s crosses partitions %d->%d, so its latency (%d ticks) "
+                 "cannot be shorter than the simulation quantum (%d "
+                 "ticks).", link->name(), src, dst,
+                 link->getLatencyTicks(), simQuantum);
+        link->setCrossPartition(getFlitPool(dst));
+        m_cross_links.push_back(link);
+        m_inbound_links[dst].push_back(link);
+    }
+    fatal_if(!m_cross_links.empty() && !m_networkbridges.empty(),
+             "Network bridges are not supported across partitions.");
+
+    // Multicast and adaptive routing depend on the complete topology,
+    // so they can only be set up once all the links have been created
+    for (auto &router : m_routers) {
+        router->initRouting();
+    }
+
     // FaultModel: declare each router to the fault model
     if (isFaultModelEnabled()) {
         for (std::vector<Router*>::const_iterator i= m_routers.begin();
@@ -285,6 +374,7 @@ GarnetNetwork::makeExtOutLink(SwitchID src, NodeID global_dest,
     } else {
         m_nis[local_dest]->addInPort(net_link, credit_link);
     }
+    m_nis[local_dest]->init_global_id(global_dest);
 
     if (garnet_link->intBridgeEn) {
         DPRINTF(RubyNetwork, "Enable internal bridge for %s\n",
@@ -386,9 +476,60 @@ GarnetNetwork::get_router_id(int global_ni, int vnet)
 {
     NodeID local_ni = getLocalNodeID(global_ni);
 
+    return get_local_router_id(local_ni, vnet);
+}
+
+// Get ID of router connected to a NI, given the NI's local ID.
+int
+GarnetNetwork::get_local_router_id(int local_ni, int vnet)
+{
     return m_nis[local_ni]->get_router_id(vnet);
 }
 
+int
+GarnetNetwork::getRouterDistance(int src, int dest) const
+{
+    if (m_num_rows <= 0)
+        return src == dest ? 0 : 1;
+
+    return std::abs(src % m_num_cols - dest % m_num_cols) +
+        std::abs(src / m_num_cols - dest / m_num_cols);
+}
+
+int
+GarnetNetwork::getMulticastTreeHops(int src,
+                                    const std::vector<int> &dests) const
+{
+    // Routers the tree goes through, besides src
+    std::vector<int> tree;
+    auto visit = [&tree](int router) {
+        if (std::find(tree.begin(), tree.end(), router) == tree.end())
+            tree.push_back(router);
+    };
+
+    for (int dest : dests) {
+        if (dest == src)
+            continue;
+        if (m_num_rows <= 0) {
+            visit(dest);
+            continue;
+        }
+
+        // X first, then Y
+        int x = src % m_num_cols, y = src / m_num_cols;
+        int dest_x = dest % m_num_cols, dest_y = dest / m_num_cols;
+        while (x != dest_x) {
+            x += x < dest_x ? 1 : -1;
+            visit(y * m_num_cols + x);
+        }
+        while (y != dest_y) {
+            y += y < dest_y ? 1 : -1;
+            visit(y * m_num_cols + x);
+        }
+    }
+    return tree.size();
+}
+
 void
 GarnetNetwork::regStats()
 {
@@ -421,11 +562,19 @@ GarnetNetwork::regStats()
         .flags(statistics::oneline)
         ;
 
+    m_ghost_packets
+        .init(m_virtual_networks)
+        .name(name() + ".ghost_packets_received")
+        .flags(statistics::total | statistics::nozero |
+            statistics::oneline)
+        ;
+
     for (int i = 0; i < m_virtual_networks; i++) {
         m_packets_received.subname(i, csprintf("vnet-%i", i));
         m_packets_injected.subname(i, csprintf("vnet-%i", i));
         m_packet_network_latency.subname(i, csprintf("vnet-%i", i));
         m_packet_queueing_latency.subname(i, csprintf("vnet-%i", i));
+        m_ghost_packets.subname(i, csprintf("vnet-%i", i));
     }
 
     m_avg_packet_vnet_latency
@@ -470,6 +619,22 @@ GarnetNetwork::regStats()
             statistics::oneline)
         ;
 
+    // Flits added by the authentication tags, the others carry the
+    // message itself
+    m_tag_flits_injected
+        .init(m_virtual_networks)
+        .name(name() + ".tag_flits_injected")
+        .flags(statistics::total | statistics::nozero |
+            statistics::oneline)
+        ;
+
+    m_payload_flits_injected
+        .name(name() + ".payload_flits_injected")
+        .flags(statistics::total | statistics::nozero |
+            statistics::oneline)
+        ;
+    m_payload_flits_injected = m_flits_injected - m_tag_flits_injected;
+
     m_flit_network_latency
         .init(m_virtual_networks)
         .name(name() + ".flit_network_latency")
@@ -485,6 +650,7 @@ GarnetNetwork::regStats()
     for (int i = 0; i < m_virtual_networks; i++) {
         m_flits_received.subname(i, csprintf("vnet-%i", i));
         m_flits_injected.subname(i, csprintf("vnet-%i", i));
+        m_tag_flits_injected.subname(i, csprintf("vnet-%i", i));
         m_flit_network_latency.subname(i, csprintf("vnet-%i", i));
         m_flit_queueing_latency.subname(i, csprintf("vnet-%i", i));
     }
@@ -516,10 +682,151 @@ GarnetNetwork::regStats()
         m_avg_flit_network_latency + m_avg_flit_queueing_latency;
 
 
+    // Multicast
+    m_multicast_completion_latency
+        .init(10)
+        .name(name() + ".multicast_completion_latency")
+        .flags(statistics::nozero)
+        ;
+
+    // Messages to several destinations by the way the NI sent them, and
+    // the destinations reached by multicast and by unicast packets
+    m_path_messages
+        .init(NUM_MULTICAST_PATH_)
+        .name(name() + ".path_messages")
+        .flags(statistics::nozero | statistics::oneline)
+        ;
+    m_path_completion_latency
+        .init(NUM_MULTICAST_PATH_)
+        .name(name() + ".path_completion_latency")
+        .flags(statistics::nozero | statistics::oneline)
+        ;
+    m_avg_path_completion_latency
+        .name(name() + ".average_path_completion_latency")
+        .flags(statistics::nozero | statistics::oneline);
+    m_avg_path_completion_latency =
+        m_path_completion_latency / m_path_messages;
+    m_path_destinations
+        .init(SPLIT_PATH_)
+        .name(name() + ".path_destinations")
+        .flags(statistics::nozero | statistics::oneline)
+        ;
+    for (int path = 0; path < NUM_MULTICAST_PATH_; path++) {
+        const char *path_name = path == MULTICAST_PATH_ ? "multicast" :
+            path == UNICAST_PATH_ ? "unicast" : "split";
+        m_path_messages.subname(path, path_name);
+        m_path_completion_latency.subname(path, path_name);
+        m_avg_path_completion_latency.subname(path, path_name);
+        if (path != SPLIT_PATH_)
+            m_path_destinations.subname(path, path_name);
+    }
+
+    // Messages and their completion latency by number of destinations
+    m_fan_out_messages
+        .init(m_nodes + 1)
+        .name(name() + ".fan_out_messages")
+        .flags(statistics::total | statistics::nozero)
+        ;
+
+    m_fan_out_completion_latency
+        .init(m_nodes + 1)
+        .name(name() + ".fan_out_completion_latency")
+        .flags(statistics::nozero)
+        ;
+
+    m_avg_fan_out_completion_latency
+        .name(name() + ".average_fan_out_completion_latency")
+        .flags(statistics::nozero);
+    m_avg_fan_out_completion_latency =
+        m_fan_out_completion_latency / m_fan_out_messages;
+
+    // Router traversals of the multicast flits, and the traversals the
+    // same flits would have taken as one unicast packet per destination
+    m_multicast_traversals
+        .name(name() + ".multicast_traversals");
+    m_multicast_unicast_traversals
+        .name(name() + ".multicast_unicast_traversals");
+    m_multicast_traversal_savings
+        .name(name() + ".multicast_traversal_savings");
+    m_multicast_traversal_savings =
+        m_multicast_unicast_traversals - m_multicast_traversals;
+
+    // Router wakeups that did or did not move a flit or a credit
+    m_router_useful_wakeups
+        .name(name() + ".router_useful_wakeups");
+    m_router_empty_wakeups
+        .name(name() + ".router_empty_wakeups");
+
+    // The same for the network interfaces
+    m_ni_useful_wakeups
+        .name(name() + ".ni_useful_wakeups");
+    m_ni_empty_wakeups
+        .name(name() + ".ni_empty_wakeups");
+
+    // Flits arriving at routers, and those that skipped the buffering
+    // stages of the router pipeline
+    m_router_hops
+        .init(m_virtual_networks)
+        .name(name() + ".router_hops")
+        .flags(statistics::oneline)
+        ;
+
+    m_bypassed_hops
+        .init(m_virtual_networks)
+        .name(name() + ".bypassed_hops")
+        .flags(statistics::oneline)
+        ;
+
+    m_bypass_fraction
+        .name(name() + ".bypass_fraction")
+        .flags(statistics::oneline)
+        ;
+    m_bypass_fraction = m_bypassed_hops / m_router_hops;
+
+    for (int i = 0; i < m_virtual_networks; i++) {
+        m_router_hops.subname(i, csprintf("vnet-%i", i));
+        m_bypassed_hops.subname(i, csprintf("vnet-%i", i));
+        m_bypass_fraction.subname(i, csprintf("vnet-%i", i));
+    }
+
+    // MAC engines
+    m_mac_tags
+        .init(m_virtual_networks)
+        .name(name() + ".mac_tags")
+        .flags(statistics::pdf | statistics::total | statistics::nozero |
+            statistics::oneline)
+        ;
+
+    m_mac_queueing_latency
+        .init(m_virtual_networks)
+        .name(name() + ".mac_queueing_latency")
+        .flags(statistics::oneline)
+        ;
+
+    for (int i = 0; i < m_virtual_networks; i++) {
+        m_mac_tags.subname(i, csprintf("vnet-%i", i));
+        m_mac_queueing_latency.subname(i, csprintf("vnet-%i", i));
+    }
+
+    m_avg_mac_queueing_latency
+        .name(name() + ".average_mac_queueing_latency");
+    m_avg_mac_queueing_latency =
+        sum(m_mac_queueing_latency) / sum(m_mac_tags);
+
     // Hops
     m_avg_hops.name(name() + ".average_hops");
     m_avg_hops = m_total_hops / sum(m_flits_received);
 
+    // Flit pool
+    m_flit_pool_hits
+        .name(name() + ".flit_pool_hits");
+    m_flit_pool_misses
+        .name(name() + ".flit_pool_misses");
+    m_flit_pool_hit_rate
+        .name(name() + ".flit_pool_hit_rate");
+    m_flit_pool_hit_rate =
+        m_flit_pool_hits / (m_flit_pool_hits + m_flit_pool_misses);
+
     // Links
     m_total_ext_in_link_utilization
         .name(name() + ".ext_in_link_utilization");
@@ -558,6 +865,180 @@ GarnetNetwork::regStats()
     }
 }
 
+void
+GarnetNetwork::startup()
+{
+    Network::startup();
+
+    if (!m_checkpoint_dir.empty())
+        restoreState();
+
+    if (m_cross_links.empty())
+        return;
+
+    fatal_if(numMainEventQueues < m_partitions,
+             "The network has %d partitions but there are only %d event "
+             "queues.", m_partitions, numMainEventQueues);
+    for (int i = 0; i < m_partitions; i++) {
+        m_delivery_events.emplace_back(new EventFunctionWrapper(
+            [this, i]{ deliverFlits(i); },
+            csprintf("%s.deliver%d", name(), i), false,
+            Event::Maximum_Pri));
+    }
+    m_exchange_event.reset(
+        new ExchangeEvent(this, curTick() + simQuantum, simQuantum));
+}
+
+// The routers, NIs and links save their own state. Only the size of
+// the network is recorded here, to check that the checkpoint fits.
+void
+GarnetNetwork::serialize(CheckpointOut &cp) const
+{
+    int num_routers = m_routers.size();
+    int num_nis = m_nis.size();
+    int num_links = m_networklinks.size();
+    SERIALIZE_SCALAR(num_routers);
+    SERIALIZE_SCALAR(num_nis);
+    SERIALIZE_SCALAR(num_links);
+}
+
+void
+GarnetNetwork::unserialize(CheckpointIn &cp)
+{
+    int num_routers, num_nis, num_links;
+    UNSERIALIZE_SCALAR(num_routers);
+    UNSERIALIZE_SCALAR(num_nis);
+    UNSERIALIZE_SCALAR(num_links);
+    fatal_if(num_routers != (int)m_routers.size() ||
+             num_nis != (int)m_nis.size() ||
+             num_links != (int)m_networklinks.size(),
+             "%s: the checkpoint is of a network with %d routers, %d NIs "
+             "and %d links.", name(), num_routers, num_nis, num_links);
+
+    // Restored at startup, see restoreState()
+    m_checkpoint_dir = cp.getCptDir();
+}
+
+// Ruby warms up its caches at startup by replaying the cache trace of
+// the checkpoint from tick 0, through the network (see
+// RubySystem::startup). The RubySystem, which is the parent of the
+// network, starts up first. The state of the network is restored after
+// the warmup so that the replayed requests do not run into it, which is
+// why it is read back from the checkpoint here rather than unserialized
+// with the other objects.
+void
+GarnetNetwork::restoreState()
+{
+    CheckpointIn cp(m_checkpoint_dir);
+
+    for (auto &router : m_routers) {
+        ScopedCheckpointSection sec(cp, router->name());
+        router->restoreState(cp);
+    }
+    for (auto &ni : m_nis) {
+        ScopedCheckpointSection sec(cp, ni->name());
+        ni->restoreState(cp);
+    }
+    std::vector<NetworkLink *> links(m_networklinks);
+    links.insert(links.end(), m_creditlinks.begin(), m_creditlinks.end());
+    links.insert(links.end(), m_networkbridges.begin(),
+                 m_networkbridges.end());
+    for (auto &link : links) {
+        ScopedCheckpointSection sec(cp, link->name());
+        link->restoreState(cp, this);
+    }
+    if (m_multicast_groups) {
+        ScopedCheckpointSection sec(cp, m_multicast_groups->name());
+        m_multicast_groups->restoreState(cp);
+    }
+
+    DPRINTF(RubyNetwork, "Restored %d packets from %s\n",
+            m_restored_packets.size(), m_checkpoint_dir);
+    m_restored_packets.clear();
+    m_checkpoint_dir.clear();
+}
+
+flit *
+GarnetNetwork::restoreFlit(const FlitState &state, FlitPool *pool)
+{
+    if (state.type == CREDIT_)
+        return new Credit(state.vc, state.free_signal, state.time);
+
+    PacketInfoPtr &packet = m_restored_packets[state.packet_id];
+    if (!packet) {
+        auto info = std::make_shared<PacketInfo>();
+        info->route.vnet = state.route_vnet;
+        info->route.src_ni = state.src_ni;
+        info->route.src_router = state.src_router;
+        info->route.dest_ni = state.dest_ni;
+        info->route.dest_router = state.dest_router;
+        packet = info;
+    }
+
+    DestMask dests;
+    for (int ni : state.dests)
+        dests.add(ni);
+
+    flit *t_flit = pool->create(state.packet_id, state.id, state.vc,
+                                state.vnet, packet, dests, state.size,
+                                state.msg_size, state.width, state.time);
+    assert(t_flit->get_type() == state.type);
+    t_flit->set_enqueue_time(state.enqueue_time);
+    t_flit->set_dequeue_time(state.dequeue_time);
+    t_flit->set_src_delay(state.src_delay);
+    t_flit->set_hops_traversed(state.hops);
+    t_flit->set_outport(state.outport);
+    t_flit->set_is_multiauth(state.multiauth);
+    t_flit->advance_stage(state.stage, state.stage_time);
+    return t_flit;
+}
+
+int
+GarnetNetwork::getPartition(const SimObject *obj) const
+{
+    return obj->params().eventq_index;
+}
+
+void
+GarnetNetwork::exchangeFlits()
+{
+    // All the event queues are waiting at the barrier, so the mailboxes
+    // of the links are not being written
+    for (auto &link : m_cross_links) {
+        link->exchangeFlits();
+    }
+    for (int i = 0; i < m_partitions; i++) {
+        if (m_inbound_links[i].empty())
+            continue;
+        assert(!m_delivery_events[i]->scheduled());
+        // Delivered by the event queue of the partition once the
+        // barrier is released
+        mainEventQueue[i]->schedule(m_delivery_events[i].get(), curTick(),
+                                    true);
+    }
+}
+
+void
+GarnetNetwork::deliverFlits(int partition)
+{
+    for (auto &link : m_inbound_links[partition]) {
+        link->deliverFlits();
+    }
+}
+
+void
+GarnetNetwork::ExchangeEvent::process()
+{
+    m_net->exchangeFlits();
+    GlobalSyncEvent::process();
+}
+
+const char *
+GarnetNetwork::ExchangeEvent::description() const
+{
+    return "GarnetNetwork flit exchange";
+}
+
 void
 GarnetNetwork::collateStats()
 {
@@ -588,6 +1069,44 @@ GarnetNetwork::collateStats()
     for (int i = 0; i < m_routers.size(); i++) {
         m_routers[i]->collateStats();
     }
+
+    double pool_hits = 0, pool_misses = 0;
+    for (auto &pool : m_flit_pools) {
+        pool_hits += pool->getHits();
+        pool_misses += pool->getMisses();
+    }
+    m_flit_pool_hits = pool_hits;
+    m_flit_pool_misses = pool_misses;
+
+    double multicast_traversals = 0;
+    double useful_wakeups = 0, empty_wakeups = 0;
+    for (auto &router : m_routers) {
+        multicast_traversals += router->get_multicast_traversals();
+        useful_wakeups += router->get_useful_wakeups();
+        empty_wakeups += router->get_empty_wakeups();
+    }
+    m_multicast_traversals = multicast_traversals;
+    m_router_useful_wakeups = useful_wakeups;
+    m_router_empty_wakeups = empty_wakeups;
+
+    useful_wakeups = 0;
+    empty_wakeups = 0;
+    for (auto &ni : m_nis) {
+        useful_wakeups += ni->get_useful_wakeups();
+        empty_wakeups += ni->get_empty_wakeups();
+    }
+    m_ni_useful_wakeups = useful_wakeups;
+    m_ni_empty_wakeups = empty_wakeups;
+
+    for (int vnet = 0; vnet < m_virtual_networks; vnet++) {
+        double buffered = 0, bypassed = 0;
+        for (auto &router : m_routers) {
+            buffered += router->get_buffered_hops(vnet);
+            bypassed += router->get_bypassed_hops(vnet);
+        }
+        m_router_hops[vnet] = buffered + bypassed;
+        m_bypassed_hops[vnet] = bypassed;
+    }
 }
 
 void
@@ -602,6 +1121,12 @@ GarnetNetwork::resetStats()
     for (int i = 0; i < m_creditlinks.size(); i++) {
         m_creditlinks[i]->resetStats();
     }
+    for (auto &pool : m_flit_pools) {
+        pool->resetStats();
+    }
+    for (auto &ni : m_nis) {
+        ni->resetStats();
+    }
 }
 
 void
@@ -611,12 +1136,25 @@ GarnetNetwork::print(std::ostream& out) const
 }
 
 void
-GarnetNetwork::update_traffic_distribution(RouteInfo route)
+GarnetNetwork::increment_delivered_messages(int fan_out,
+                                            MulticastPath path,
+                                            Tick latency)
 {
-    int src_node = route.src_router;
-    int dest_node = route.dest_router;
-    int vnet = route.vnet;
+    auto lock = lockStats();
+    m_fan_out_messages[fan_out]++;
+    m_fan_out_completion_latency[fan_out] += latency;
+    if (fan_out > 1) {
+        m_multicast_completion_latency.sample(latency);
+        m_path_messages[path]++;
+        m_path_completion_latency[path] += latency;
+    }
+}
 
+void
+GarnetNetwork::update_traffic_distribution(int src_node, int dest_node,
+                                           int vnet)
+{
+    auto lock = lockStats();
     if (m_vnet_type[vnet] == DATA_VNET_)
         (*m_data_traffic_distribution[src_node][dest_node])++;
     else
@@ -33,12 +33,19 @@
 #define __MEM_RUBY_NETWORK_GARNET_0_GARNETNETWORK_HH__
 
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "mem/ruby/network/Network.hh"
 #include "mem/ruby/network/fault_model/FaultModel.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
+#include "mem/ruby/network/garnet/FlitPool.hh"
+#include "mem/ruby/network/garnet/FlitTracer.hh"
 #include "params/GarnetNetwork.hh"
+#include "sim/global_event.hh"
 
 namespace gem5
 {
@@ -52,6 +59,7 @@ class NetDest;
 namespace garnet
 {
 
+class MulticastGroupGenerator;
 class NetworkInterface;
 class Router;
 class NetworkLink;
@@ -66,6 +74,10 @@ class GarnetNetwork : public Network
     ~GarnetNetwork() = default;
 
     void init();
+    void startup();
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
 
     const char *garnetVersion = "3.0";
 
@@ -85,6 +97,9 @@ class GarnetNetwork : public Network
     FaultModel* fault_model;
 
     bool isMulticastEnabled() { return m_enable_multicast; }
+    // Switch between multicast and multiple unicast between sweep points
+    void setMulticastEnabled(bool enable) { m_enable_multicast = enable; }
+    bool isBypassEnabled() const { return m_enable_bypass; }
 
     // Internal configuration
     bool isVNetOrdered(int vnet) const { return m_ordered[vnet]; }
@@ -95,6 +110,13 @@ class GarnetNetwork : public Network
     }
     int getNumRouters();
     int get_router_id(int ni, int vnet);
+    int get_local_router_id(int local_ni, int vnet);
+
+    // Hops from router src to router dest, and hops of the multicast
+    // tree from src to all the dests, along the XY routes of a mesh.
+    // Without mesh rows any two routers are one hop apart.
+    int getRouterDistance(int src, int dest) const;
+    int getMulticastTreeHops(int src, const std::vector<int> &dests) const;
 
 
     // Methods used by Topology to setup the network
@@ -119,44 +141,132 @@ class GarnetNetwork : public Network
     void print(std::ostream& out) const;
 
     // increment counters
-    void increment_injected_packets(int vnet) { m_packets_injected[vnet]++; }
-    void increment_received_packets(int vnet) { m_packets_received[vnet]++; }
+    void
+    increment_injected_packets(int vnet)
+    {
+        auto lock = lockStats();
+        m_packets_injected[vnet]++;
+    }
+
+    void
+    increment_received_packets(int vnet)
+    {
+        auto lock = lockStats();
+        m_packets_received[vnet]++;
+    }
 
     void
     increment_packet_network_latency(Tick latency, int vnet)
     {
+        auto lock = lockStats();
         m_packet_network_latency[vnet] += latency;
     }
 
     void
     increment_packet_queueing_latency(Tick latency, int vnet)
     {
+        auto lock = lockStats();
         m_packet_queueing_latency[vnet] += latency;
     }
 
-    void increment_injected_flits(int vnet) { m_flits_injected[vnet]++; }
-    void increment_received_flits(int vnet) { m_flits_received[vnet]++; }
+    void
+    increment_injected_flits(int vnet)
+    {
+        auto lock = lockStats();
+        m_flits_injected[vnet]++;
+    }
+
+    void
+    increment_received_flits(int vnet)
+    {
+        auto lock = lockStats();
+        m_flits_received[vnet]++;
+    }
+
+    void
+    increment_injected_tag_flits(int vnet, int flits)
+    {
+        auto lock = lockStats();
+        m_tag_flits_injected[vnet] += flits;
+    }
 
     void
     increment_flit_network_latency(Tick latency, int vnet)
     {
+        auto lock = lockStats();
         m_flit_network_latency[vnet] += latency;
     }
 
     void
     increment_flit_queueing_latency(Tick latency, int vnet)
     {
+        auto lock = lockStats();
         m_flit_queueing_latency[vnet] += latency;
     }
 
+    void
+    increment_multicast_unicast_traversals(int traversals)
+    {
+        auto lock = lockStats();
+        m_multicast_unicast_traversals += traversals;
+    }
+
+    void increment_delivered_messages(int fan_out, MulticastPath path,
+                                      Tick latency);
+
+    void
+    increment_path_destinations(MulticastPath path, int dests)
+    {
+        auto lock = lockStats();
+        m_path_destinations[path] += dests;
+    }
+
+    void
+    increment_ghost_packets(int vnet)
+    {
+        auto lock = lockStats();
+        m_ghost_packets[vnet]++;
+    }
+
+    void
+    increment_mac_tags(int vnet, Tick wait)
+    {
+        auto lock = lockStats();
+        m_mac_tags[vnet]++;
+        m_mac_queueing_latency[vnet] += wait;
+    }
+
     void
     increment_total_hops(int hops)
     {
+        auto lock = lockStats();
         m_total_hops += hops;
     }
 
-    void update_traffic_distribution(RouteInfo route);
-    int getNextPacketID() { return m_next_packet_id++; }
+    void update_traffic_distribution(int src_node, int dest_node, int vnet);
+
+    // Each partition allocates its flits from its own pool
+    int getNumPartitions() const { return m_partitions; }
+    FlitPool *
+    getFlitPool(int partition)
+    {
+        return m_flit_pools[partition].get();
+    }
+
+    // NULL unless flit tracing is enabled
+    FlitTracer *getFlitTracer() const { return m_flit_tracer.get(); }
+
+    // Recreate a flit saved in a checkpoint, allocated from pool. The
+    // flits of a packet, and all its multicast branches, share the
+    // packet info again.
+    flit *restoreFlit(const FlitState &state, FlitPool *pool);
+
+    // NULL when the protocol destinations are used as they are
+    MulticastGroupGenerator *
+    getMulticastGroups() const
+    {
+        return m_multicast_groups;
+    }
 
   protected:
     // Configuration
@@ -169,12 +279,19 @@ class GarnetNetwork : public Network
     int m_routing_algorithm;
     bool m_enable_fault_model;
     bool m_enable_multicast;
+    bool m_enable_bypass;
+    uint32_t m_flit_pool_size;
+    std::string m_flit_trace_file;
+    MulticastGroupGenerator *m_multicast_groups;
+    int m_partitions;
 
     // Statistical variables
     statistics::Vector m_packets_received;
     statistics::Vector m_packets_injected;
     statistics::Vector m_packet_network_latency;
     statistics::Vector m_packet_queueing_latency;
+    // Packets restored from a checkpoint, dropped at their destination
+    statistics::Vector m_ghost_packets;
 
     statistics::Formula m_avg_packet_vnet_latency;
     statistics::Formula m_avg_packet_vqueue_latency;
@@ -184,6 +301,8 @@ class GarnetNetwork : public Network
 
     statistics::Vector m_flits_received;
     statistics::Vector m_flits_injected;
+    statistics::Vector m_tag_flits_injected;
+    statistics::Formula m_payload_flits_injected;
     statistics::Vector m_flit_network_latency;
     statistics::Vector m_flit_queueing_latency;
 
@@ -199,9 +318,37 @@ class GarnetNetwork : public Network
     statistics::Scalar m_average_link_utilization;
     statistics::Vector m_average_vc_load;
 
+    // Multicast
+    statistics::Histogram m_multicast_completion_latency;
+    statistics::Vector  m_path_messages;
+    statistics::Vector  m_path_completion_latency;
+    statistics::Formula m_avg_path_completion_latency;
+    statistics::Vector  m_path_destinations;
+    statistics::Vector  m_fan_out_messages;
+    statistics::Vector  m_fan_out_completion_latency;
+    statistics::Formula m_avg_fan_out_completion_latency;
+    statistics::Scalar  m_multicast_traversals;
+    statistics::Scalar  m_router_useful_wakeups;
+    statistics::Scalar  m_router_empty_wakeups;
+    statistics::Scalar  m_ni_useful_wakeups;
+    statistics::Scalar  m_ni_empty_wakeups;
+    statistics::Vector  m_router_hops;
+    statistics::Vector  m_bypassed_hops;
+    statistics::Formula m_bypass_fraction;
+    statistics::Scalar  m_multicast_unicast_traversals;
+    statistics::Formula m_multicast_traversal_savings;
+
+    statistics::Vector  m_mac_tags;
+    statistics::Vector  m_mac_queueing_latency;
+    statistics::Formula m_avg_mac_queueing_latency;
+
     statistics::Scalar  m_total_hops;
     statistics::Formula m_avg_hops;
 
+    statistics::Scalar  m_flit_pool_hits;
+    statistics::Scalar  m_flit_pool_misses;
+    statistics::Formula m_flit_pool_hit_rate;
+
     std::vector<std::vector<statistics::Scalar *>> m_data_traffic_distribution;
     std::vector<std::vector<statistics::Scalar *>> m_ctrl_traffic_distribution;
 
@@ -215,7 +362,54 @@ class GarnetNetwork : public Network
     std::vector<NetworkBridge *> m_networkbridges; // All network bridges
     std::vector<CreditLink *> m_creditlinks; // All credit links in the network
     std::vector<NetworkInterface *> m_nis;   // All NI's in Network
-    int m_next_packet_id; // static vairable for packet id allocation
+    // storage for the flits of each partition
+    std::vector<std::unique_ptr<FlitPool>> m_flit_pools;
+    std::unique_ptr<FlitTracer> m_flit_tracer;
+
+    // Partitioned simulation: the routers and NIs run on several event
+    // queues. The links between partitions are exchanged at every
+    // quantum boundary while all the event queues wait at a barrier;
+    // then each partition delivers the flits of its inbound links.
+    class ExchangeEvent : public GlobalSyncEvent
+    {
+      public:
+        ExchangeEvent(GarnetNetwork *net, Tick when, Tick quantum)
+            : GlobalSyncEvent(when, quantum, Maximum_Pri, 0), m_net(net)
+        {}
+
+        void process() override;
+        const char *description() const override;
+
+      private:
+        GarnetNetwork *m_net;
+    };
+
+    void exchangeFlits();
+    void deliverFlits(int partition);
+    int getPartition(const SimObject *obj) const;
+
+    // Restore the state of the routers, NIs and links from the
+    // checkpoint the network was unserialized from
+    void restoreState();
+    std::string m_checkpoint_dir;
+    std::unordered_map<int, PacketInfoPtr> m_restored_packets;
+
+    std::unique_ptr<ExchangeEvent> m_exchange_event;
+    std::vector<NetworkLink *> m_cross_links;
+    // Cross-partition links per partition of their consumer
+    std::vector<std::vector<NetworkLink *>> m_inbound_links;
+    std::vector<std::unique_ptr<EventFunctionWrapper>> m_delivery_events;
+
+    // The partitions update the network-wide stats concurrently
+    std::mutex m_stats_mutex;
+
+    std::unique_lock<std::mutex>
+    lockStats()
+    {
+        if (m_partitions > 1)
+            return std::unique_lock<std::mutex>(m_stats_mutex);
+        return std::unique_lock<std::mutex>();
+    }
 };
 
 inline std::ostream&
@@ -28,11 +28,15 @@
 # Author: Tushar Krishna
 #
 
+from m5.defines import buildEnv
 from m5.params import *
 from m5.proxy import *
+from m5.SimObject import SimObject, PyBindMethod
 from m5.objects.Network import RubyNetwork
 from m5.objects.BasicRouter import BasicRouter
 from m5.objects.ClockedObject import ClockedObject
+from m5.objects.MulticastGroupGenerator import *
+from m5.util import fatal
 
 
 class GarnetNetwork(RubyNetwork):
@@ -40,12 +44,18 @@ class GarnetNetwork(RubyNetwork):
     cxx_header = "mem/ruby/network/garnet/GarnetNetwork.hh"
     cxx_class = "gem5::ruby::garnet::GarnetNetwork"
 
+    cxx_exports = [PyBindMethod("setMulticastEnabled")]
+
     num_rows = Param.Int(0, "number of rows if 2D (mesh/torus/..) topology")
     ni_flit_size = Param.UInt32(16, "network interface flit size in bytes")
     vcs_per_vnet = Param.UInt32(4, "virtual channels per virtual network")
     buffers_per_data_vc = Param.UInt32(4, "buffers per data virtual channel")
     buffers_per_ctrl_vc = Param.UInt32(1, "buffers per ctrl virtual channel")
-    routing_algorithm = Param.Int(0, "0: Weight-based Table, 1: XY, 2: Custom")
+    routing_algorithm = Param.Int(
+        0,
+        "0: Weight-based Table, 1: XY, 2: Custom, "
+        "3: West-first adaptive, 4: Odd-even adaptive",
+    )
     enable_fault_model = Param.Bool(False, "enable network fault model")
     fault_model = Param.FaultModel(NULL, "network fault model")
     garnet_deadlock_threshold = Param.UInt32(
@@ -57,7 +67,127 @@ class GarnetNetwork(RubyNetwork):
     multicast_verify_cycles = Param.UInt32(
         26, "cycles to multicast verify"
     )
+    siphash_cycles = Param.UInt32(
+        10, "cycles to compute the SipHash tag of a unicast message"
+    )
+    siphash_cycles_per_byte = Param.Float(
+        0.0, "additional SipHash cycles per byte of the message"
+    )
+    siphash_tag_bytes = Param.UInt32(8, "size of a SipHash tag")
+    auth_tags_in_flits = Param.Bool(
+        False, "add the authentication tag bytes to the packet flits"
+    )
+    multiauth_max_dests = VectorParam.UInt32(
+        [4, 8], "largest multicast group of each multi-auth tag size"
+    )
+    multiauth_tag_bytes = VectorParam.UInt32(
+        [26, 40], "multi-auth tag size for each multiauth_max_dests entry"
+    )
+    mac_lanes = Param.UInt32(1, "parallel lanes of the NI MAC engine")
+    mac_pipeline_stages = Param.UInt32(
+        1, "pipeline stages of a MAC engine lane"
+    )
+    mac_queue_depth = Param.UInt32(
+        0,
+        "tags per vnet that can wait for a MAC engine lane "
+        "(0: messages wait in the protocol buffers until a lane is free)",
+    )
     enable_multicast = Param.Bool(False, "enable multicast routing")
+    hybrid_multicast = Param.Bool(
+        False,
+        "with enable_multicast, let the NI choose per message between one "
+        "multicast packet, one unicast packet per destination, or a "
+        "multicast packet to the clustered destinations and unicast "
+        "packets to the stragglers",
+    )
+    straggler_hops = Param.UInt32(
+        2,
+        "hybrid_multicast: a destination farther than this many hops "
+        "from all the other destinations is a straggler",
+    )
+    hybrid_load_weight = Param.Float(
+        1.0,
+        "hybrid_multicast: cycles charged per flit hop a path adds to "
+        "the network when all the NI output VCs of the vnet are busy",
+    )
+    enable_bypass = Param.Bool(
+        False,
+        "let single-flit packets that arrive at an idle router skip the "
+        "buffering stages of the router pipeline",
+    )
+    flit_trace_file = Param.String(
+        "",
+        "record the injection, router hops and ejection of every flit to "
+        "this binary file in the output directory (empty: no trace)",
+    )
+    flit_pool_size = Param.UInt32(
+        0,
+        "flits preallocated by the flit pool "
+        "(0: as many as the router buffers can hold)",
+    )
+    multicast_groups = Param.MulticastGroupGenerator(
+        UniformMulticastGroups(),
+        "turns message destinations into multicast groups "
+        "(NULL: keep the destinations set by the protocol)",
+    )
+    partitions = Param.UInt32(
+        1,
+        "event queues the routers and NIs are spread over; the links "
+        "between them exchange flits at every simulation quantum "
+        "(Garnet_standalone only)",
+    )
+
+    def partition_by_region(self, partitions):
+        """Spread the routers over partitions event queues, in bands of
+        mesh rows (or of consecutive router ids if there are no rows).
+        The NIs, controllers and external links of a router run on its
+        event queue. A link between routers runs on the event queue of
+        its source: the flit link on the upstream router's, the credit
+        link on the downstream router's.
+
+        Only Garnet_standalone can be partitioned. Its controllers only
+        talk to their own NI. The controllers of a coherence protocol
+        share the sequencers, directories and memory with controllers
+        of other regions, which would then run on other event queues."""
+        self.partitions = partitions
+        if partitions == 1:
+            return
+        if buildEnv["PROTOCOL"] != "Garnet_standalone":
+            fatal(
+                "Garnet can only be partitioned with Garnet_standalone, "
+                f"not {buildEnv['PROTOCOL']}"
+            )
+
+        num_routers = len(self.routers)
+        num_rows = int(self.num_rows)
+        if num_rows > 0:
+            num_cols = num_routers // num_rows
+            region = lambda i: (i // num_cols) * partitions // num_rows
+        else:
+            region = lambda i: i * partitions // num_routers
+
+        partition = {}
+        for i, router in enumerate(self.routers):
+            router.eventq_index = region(i)
+            partition[id(router)] = region(i)
+
+        for int_link in self.int_links:
+            src = partition[id(int_link.src_node)]
+            dst = partition[id(int_link.dst_node)]
+            int_link.eventq_index = src
+            int_link.network_link.eventq_index = src
+            int_link.credit_link.eventq_index = dst
+
+        for ext_link, netif in zip(self.ext_links, self.netifs):
+            p = partition[id(ext_link.int_node)]
+            ext_link.eventq_index = p
+            netif.eventq_index = p
+            ext_link.ext_node.eventq_index = p
+            # The sequencer is a child of its controller, but is set
+            # explicitly so that configs can put its CPU next to it
+            sequencer = getattr(ext_link.ext_node, "sequencer", None)
+            if isinstance(sequencer, SimObject):
+                sequencer.eventq_index = p
 
 
 class GarnetNetworkInterface(ClockedObject):
@@ -81,6 +211,40 @@ class GarnetNetworkInterface(ClockedObject):
     multicast_verify_cycles = Param.UInt32(
         Parent.multicast_verify_cycles, "network-level deadlock threshold"
     )
+    siphash_cycles = Param.UInt32(
+        Parent.siphash_cycles, "cycles to compute a SipHash tag"
+    )
+    siphash_cycles_per_byte = Param.Float(
+        Parent.siphash_cycles_per_byte, "additional SipHash cycles per byte"
+    )
+    siphash_tag_bytes = Param.UInt32(
+        Parent.siphash_tag_bytes, "size of a SipHash tag"
+    )
+    auth_tags_in_flits = Param.Bool(
+        Parent.auth_tags_in_flits, "add the tag bytes to the packet flits"
+    )
+    multiauth_max_dests = VectorParam.UInt32(
+        Parent.multiauth_max_dests, "largest group of each multi-auth tag"
+    )
+    multiauth_tag_bytes = VectorParam.UInt32(
+        Parent.multiauth_tag_bytes, "multi-auth tag sizes"
+    )
+    mac_lanes = Param.UInt32(Parent.mac_lanes, "MAC engine lanes")
+    mac_pipeline_stages = Param.UInt32(
+        Parent.mac_pipeline_stages, "pipeline stages of a MAC engine lane"
+    )
+    mac_queue_depth = Param.UInt32(
+        Parent.mac_queue_depth, "tags per vnet waiting for a lane"
+    )
+    hybrid_multicast = Param.Bool(
+        Parent.hybrid_multicast, "choose the multicast path per message"
+    )
+    straggler_hops = Param.UInt32(
+        Parent.straggler_hops, "hops that make a destination a straggler"
+    )
+    hybrid_load_weight = Param.Float(
+        Parent.hybrid_load_weight, "cycles charged per flit hop under load"
+    )
 
 
 class GarnetRouter(BasicRouter):
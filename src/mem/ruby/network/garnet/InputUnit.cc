@@ -31,6 +31,9 @@
 
 #include "mem/ruby/network/garnet/InputUnit.hh"
 
+#include <algorithm>
+
+#include "base/cprintf.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/Credit.hh"
 #include "mem/ruby/network/garnet/Router.hh"
@@ -46,20 +49,33 @@ namespace garnet
 
 InputUnit::InputUnit(int id, PortDirection direction, Router *router)
   : Consumer(router), m_router(router), m_id(id), m_direction(direction),
-    m_vc_per_vnet(m_router->get_vc_per_vnet())
+    m_vc_per_vnet(m_router->get_vc_per_vnet()), m_num_flits(0)
 {
     const int m_num_vcs = m_router->get_num_vcs();
     m_num_buffer_reads.resize(m_num_vcs/m_vc_per_vnet);
     m_num_buffer_writes.resize(m_num_vcs/m_vc_per_vnet);
+    m_num_bypasses.assign(m_num_vcs/m_vc_per_vnet, 0);
     for (int i = 0; i < m_num_buffer_reads.size(); i++) {
         m_num_buffer_reads[i] = 0;
         m_num_buffer_writes[i] = 0;
     }
 
-    // Instantiating the virtual channels
+    // Instantiating the virtual channels. Credits keep the flits in a
+    // VC within the buffers of its vnet.
+    GarnetNetwork *net = m_router->get_net_ptr();
     virtualChannels.reserve(m_num_vcs);
     for (int i=0; i < m_num_vcs; i++) {
-        virtualChannels.emplace_back();
+        int vnet = i / m_vc_per_vnet;
+        virtualChannels.emplace_back(net->get_vnet_type(vnet) == DATA_VNET_ ?
+            net->getBuffersPerDataVC() : net->getBuffersPerCtrlVC());
+    }
+}
+
+void
+InputUnit::init()
+{
+    for (auto &vc : virtualChannels) {
+        vc.init_out_info(m_router->get_num_outports());
     }
 }
 
@@ -87,6 +103,7 @@ InputUnit::wakeup()
 
         int vc = t_flit->get_vc();
         t_flit->increment_hops(); // for stats
+        m_router->traceFlit(TRACE_ROUTER_IN_, t_flit, m_id, -1, vc);
 
         if ((t_flit->get_type() == HEAD_) ||
             (t_flit->get_type() == HEAD_TAIL_)) {
@@ -95,19 +112,23 @@ InputUnit::wakeup()
             set_vc_active(vc, curTick());
 
             // Route computation for this vc
-            std::vector<OutInfo> out_info(m_router->get_num_outports());
-	        auto routes = t_flit->get_routes();
-	        auto msg_ptrs = t_flit->get_msg_ptrs();
-            for (int i = 0; i < routes.size(); i++) {
-                int outport = m_router->route_compute(routes[i], m_id, m_direction);
-                out_info[outport].routes.push_back(routes[i]);
-		        out_info[outport].msg_ptrs.push_back(msg_ptrs[i]);
-            }
-
-            // Update output port in VC
-            // All flits in this packet will use this output port
+            // The output ports are recorded in the VC; all flits in this
+            // packet will use these output ports.
             // The output port field in the flit is updated after it wins SA
-            set_out_info(vc, out_info);
+            OutInfoTable &out_info = get_out_info(vc);
+            const RouteInfo &route = t_flit->get_route();
+            if (route.isMulticast()) {
+                // Split the destinations among the branches of the
+                // multicast tree at this router
+                m_router->route_compute_multicast(route,
+                    t_flit->get_dest_mask(), out_info);
+            } else {
+                VC_class_type vc_class = ANY_VC_;
+                int outport = m_router->route_compute(route, m_id,
+                                                      m_direction, vc,
+                                                      vc_class);
+                out_info.add(outport, t_flit->get_dest_mask(), vc_class);
+            }
 
         } else {
             assert(virtualChannels[vc].get_state() == ACTIVE_);
@@ -116,14 +137,24 @@ InputUnit::wakeup()
 
         // Buffer the flit
         virtualChannels[vc].insertFlit(t_flit);
+        m_num_flits++;
 
         int vnet = vc/m_vc_per_vnet;
-        // number of writes same as reads
-        // any flit that is written will be read only once
-        m_num_buffer_writes[vnet]++;
-        m_num_buffer_reads[vnet]++;
-
         Cycles pipe_stages = m_router->get_pipe_stages();
+        if (m_router->can_bypass(m_id, vc)) {
+            // The flit is switched in the cycle it arrives,
+            // without being written to the buffer
+            DPRINTF(RubyNetwork, "Router[%d] bypassing flit %s\n",
+                    m_router->get_id(), *t_flit);
+            m_num_bypasses[vnet]++;
+            pipe_stages = Cycles(1);
+        } else {
+            // number of writes same as reads
+            // any flit that is written will be read only once
+            m_num_buffer_writes[vnet]++;
+            m_num_buffer_reads[vnet]++;
+        }
+
         if (pipe_stages == 1) {
             // 1-cycle router
             // Flit goes for SA directly
@@ -181,12 +212,50 @@ InputUnit::functionalWrite(Packet *pkt)
     return num_functional_writes;
 }
 
+void
+InputUnit::serialize(CheckpointOut &cp) const
+{
+    for (int vc = 0; vc < (int)virtualChannels.size(); vc++) {
+        Serializable::ScopedCheckpointSection sec(cp, csprintf("vc%d", vc));
+        virtualChannels[vc].serialize(cp);
+    }
+    serializeFlits(cp, "credits", creditQueue.getFlits());
+}
+
+void
+InputUnit::restoreState(CheckpointIn &cp)
+{
+    GarnetNetwork *net = m_router->get_net_ptr();
+    for (int vc = 0; vc < (int)virtualChannels.size(); vc++) {
+        VirtualChannel &virtual_channel = virtualChannels[vc];
+        {
+            Serializable::ScopedCheckpointSection sec(
+                cp, csprintf("vc%d", vc));
+            virtual_channel.restoreState(cp, net, m_router->getFlitPool());
+        }
+        m_num_flits += virtual_channel.get_num_flits();
+
+        // Wake up the router for the switch allocation of the flit at
+        // the head of the VC
+        if (virtual_channel.get_num_flits() > 0) {
+            Tick sa_time = virtual_channel.peekTopFlit()->get_stage().second;
+            m_router->scheduleEventAbsolute(std::max(sa_time, curTick()));
+        }
+    }
+
+    for (const auto &state : unserializeFlits(cp, "credits"))
+        creditQueue.insert(net->restoreFlit(state, nullptr));
+    if (!creditQueue.isEmpty())
+        m_credit_link->scheduleEventAbsolute(curTick());
+}
+
 void
 InputUnit::resetStats()
 {
     for (int j = 0; j < m_num_buffer_reads.size(); j++) {
         m_num_buffer_reads[j] = 0;
         m_num_buffer_writes[j] = 0;
+        m_num_bypasses[j] = 0;
     }
 }
 
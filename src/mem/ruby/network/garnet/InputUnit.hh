@@ -58,6 +58,7 @@ class InputUnit : public Consumer
     InputUnit(int id, PortDirection direction, Router *router);
     ~InputUnit() = default;
 
+    void init();
     void wakeup();
     void print(std::ostream& out) const {};
 
@@ -75,19 +76,7 @@ class InputUnit : public Consumer
         virtualChannels[vc].set_active(curTime);
     }
 
-    inline void
-    set_out_info(int vc, std::vector<OutInfo> out_info)
-    {
-        virtualChannels[vc].set_out_info(out_info);
-    }
-
-    inline void
-    update_out_info(int vc, int outport, OutInfo out_info)
-    {
-        virtualChannels[vc].update_out_info(outport, out_info);
-    }
-
-    inline std::vector<OutInfo>
+    inline OutInfoTable&
     get_out_info(int invc)
     {
         return virtualChannels[invc].get_out_info();
@@ -110,9 +99,19 @@ class InputUnit : public Consumer
     inline flit*
     getTopFlit(int vc)
     {
+        m_num_flits--;
         return virtualChannels[vc].getTopFlit();
     }
 
+    // Flits buffered in all the VCs of this input port
+    inline int get_num_flits() { return m_num_flits; }
+
+    inline bool
+    has_incoming_flit()
+    {
+        return m_in_link->isReady(curTick());
+    }
+
     inline bool
     need_stage(int vc, flit_stage stage, Tick time)
     {
@@ -145,10 +144,15 @@ class InputUnit : public Consumer
     { return m_num_buffer_reads[vnet]; }
     double get_buf_write_activity(unsigned int vnet) const
     { return m_num_buffer_writes[vnet]; }
+    double get_bypass_activity(unsigned int vnet) const
+    { return m_num_bypasses[vnet]; }
 
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *pkt);
 
+    void serialize(CheckpointOut &cp) const;
+    void restoreState(CheckpointIn &cp);
+
     void resetStats();
 
   private:
@@ -162,10 +166,12 @@ class InputUnit : public Consumer
 
     // Input Virtual channels
     std::vector<VirtualChannel> virtualChannels;
+    int m_num_flits;
 
     // Statistical variables
     std::vector<double> m_num_buffer_writes;
     std::vector<double> m_num_buffer_reads;
+    std::vector<double> m_num_bypasses;
 };
 
 } // namespace garnet
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#include "mem/ruby/network/garnet/MacEngine.hh"
+
+#include <algorithm>
+#include <cassert>
+
+#include "base/cprintf.hh"
+#include "base/intmath.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+MacEngine::MacEngine()
+    : m_num_stages(1), m_queue_depth(0)
+{
+}
+
+void
+MacEngine::init(int num_lanes, int num_stages, int queue_depth,
+                int num_vnets)
+{
+    assert(num_lanes > 0 && num_stages > 0 && queue_depth >= 0);
+    m_num_stages = num_stages;
+    m_queue_depth = queue_depth;
+    m_lane_free.assign(num_lanes, 0);
+    m_waiting.assign(num_vnets, std::deque<Tick>());
+}
+
+int
+MacEngine::earliestLane() const
+{
+    return std::min_element(m_lane_free.begin(), m_lane_free.end()) -
+        m_lane_free.begin();
+}
+
+bool
+MacEngine::canAccept(int vnet, Tick now)
+{
+    // Tags are started in the order they are reserved, so each queue
+    // is sorted by start time
+    std::deque<Tick> &waiting = m_waiting[vnet];
+    while (!waiting.empty() && waiting.front() <= now)
+        waiting.pop_front();
+
+    return m_lane_free[earliestLane()] <= now ||
+        (int)waiting.size() < m_queue_depth;
+}
+
+Tick
+MacEngine::reserve(int vnet, Tick now, Cycles latency, Tick period,
+                   Tick &wait)
+{
+    int lane = earliestLane();
+    Tick start = std::max(now, m_lane_free[lane]);
+
+    // The first stage is busy for its share of the latency
+    m_lane_free[lane] =
+        start + divCeil((uint64_t)latency, m_num_stages) * period;
+
+    if (start > now)
+        m_waiting[vnet].push_back(start);
+    wait = start - now;
+
+    return start + latency * period;
+}
+
+std::vector<Cycles>
+MacEngine::estimate(Tick now, const std::vector<Cycles> &latencies,
+                    Tick period) const
+{
+    std::vector<Tick> lane_free = m_lane_free;
+    std::vector<Cycles> ready;
+    for (Cycles latency : latencies) {
+        auto lane = std::min_element(lane_free.begin(), lane_free.end());
+        Tick start = std::max(now, *lane);
+        *lane = start + divCeil((uint64_t)latency, m_num_stages) * period;
+        ready.push_back(Cycles(divCeil(start - now, period)) + latency);
+    }
+    return ready;
+}
+
+void
+MacEngine::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_CONTAINER(m_lane_free);
+    for (int vnet = 0; vnet < (int)m_waiting.size(); vnet++)
+        arrayParamOut(cp, csprintf("waiting%d", vnet), m_waiting[vnet]);
+}
+
+void
+MacEngine::unserialize(CheckpointIn &cp)
+{
+    std::vector<Tick> lane_free;
+    arrayParamIn(cp, "m_lane_free", lane_free);
+    fatal_if(lane_free.size() != m_lane_free.size(),
+             "The checkpoint is of a MAC engine with %d lanes.",
+             lane_free.size());
+    m_lane_free = lane_free;
+    for (int vnet = 0; vnet < (int)m_waiting.size(); vnet++)
+        arrayParamIn(cp, csprintf("waiting%d", vnet), m_waiting[vnet]);
+}
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
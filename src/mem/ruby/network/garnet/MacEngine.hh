@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_0_MACENGINE_HH__
+#define __MEM_RUBY_NETWORK_GARNET_0_MACENGINE_HH__
+
+#include <deque>
+#include <vector>
+
+#include "base/types.hh"
+#include "sim/serialize.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+// MacEngine models the crypto engine an NI uses to compute the
+// authentication tags of the messages it injects. The engine has
+// num_lanes identical lanes. A lane is pipelined num_stages deep, so it
+// can start a new tag every 1/num_stages of the tag latency. Tags that
+// cannot start right away wait in a queue of their vnet, which holds at
+// most queue_depth tags; a message that does not fit stays in its
+// protocol buffer without blocking the other vnets.
+class MacEngine : public Serializable
+{
+  public:
+    MacEngine();
+
+    void init(int num_lanes, int num_stages, int queue_depth,
+              int num_vnets);
+
+    // Whether a new message of this vnet can be accepted at time now
+    bool canAccept(int vnet, Tick now);
+
+    // Reserve a lane for a tag taking latency cycles of length period.
+    // Returns the time at which the tag is ready and sets wait to the
+    // time the tag waits for a lane.
+    Tick reserve(int vnet, Tick now, Cycles latency, Tick period,
+                 Tick &wait);
+
+    // Cycles from now until each of these tags would be ready if they
+    // were reserved in this order. Nothing is reserved.
+    std::vector<Cycles> estimate(Tick now,
+                                 const std::vector<Cycles> &latencies,
+                                 Tick period) const;
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+  private:
+    int earliestLane() const;
+
+    int m_num_stages;
+    int m_queue_depth;
+
+    // time at which each lane can start a new tag
+    std::vector<Tick> m_lane_free;
+
+    // start times of the tags waiting for a lane, per vnet
+    std::vector<std::deque<Tick>> m_waiting;
+};
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_GARNET_0_MACENGINE_HH__
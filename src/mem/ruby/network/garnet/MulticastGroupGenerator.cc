@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#include "mem/ruby/network/garnet/MulticastGroupGenerator.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "base/cprintf.hh"
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "sim/sim_exit.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+namespace
+{
+
+// A group record starts with the magic, the version and the number of
+// NIs. Each group follows as the NI that picked it, the number of members
+// and the members. All are 16-bit little-endian words.
+const char recordMagic[4] = {'M', 'C', 'G', 'R'};
+const uint16_t recordVersion = 1;
+
+void
+writeWord(std::ostream &os, uint16_t word)
+{
+    char bytes[2] = {char(word & 0xff), char(word >> 8)};
+    os.write(bytes, 2);
+}
+
+bool
+readWord(std::istream &is, uint16_t &word)
+{
+    unsigned char bytes[2];
+    if (!is.read((char *)bytes, 2))
+        return false;
+    word = bytes[0] | (bytes[1] << 8);
+    return true;
+}
+
+} // anonymous namespace
+
+MulticastGroupGenerator::MulticastGroupGenerator(const Params &p)
+    : SimObject(p), m_vnets(p.vnets), m_seed(p.seed), m_record(nullptr)
+{
+    if (!p.record_file.empty()) {
+        m_record = simout.create(p.record_file, true);
+        registerExitCallback([this]() { m_record->stream()->flush(); });
+    }
+}
+
+void
+MulticastGroupGenerator::initStreams(int num_nis)
+{
+    fatal_if(num_nis > 0xffff, "%s: too many NIs (%d).", name(), num_nis);
+
+    m_streams.resize(num_nis);
+    for (int ni = 0; ni < num_nis; ni++)
+        m_streams[ni].rng.init(m_seed + uint32_t(ni) * 0x9e3779b9u);
+
+    if (m_record) {
+        std::ostream &os = *m_record->stream();
+        os.write(recordMagic, sizeof(recordMagic));
+        writeWord(os, recordVersion);
+        writeWord(os, num_nis);
+    }
+}
+
+void
+MulticastGroupGenerator::serialize(CheckpointOut &cp) const
+{
+    int num_streams = m_streams.size();
+    SERIALIZE_SCALAR(num_streams);
+    for (int ni = 0; ni < num_streams; ni++) {
+        ScopedCheckpointSection sec(cp, csprintf("stream%d", ni));
+        const Stream &stream = m_streams[ni];
+        paramOut(cp, "num_groups", stream.num_groups);
+        stream.rng.serializeSection(cp, "rng");
+    }
+}
+
+void
+MulticastGroupGenerator::restoreState(CheckpointIn &cp)
+{
+    int num_streams;
+    UNSERIALIZE_SCALAR(num_streams);
+    fatal_if(num_streams != (int)m_streams.size(),
+             "%s: the checkpoint has %d streams.", name(), num_streams);
+    for (int ni = 0; ni < num_streams; ni++) {
+        ScopedCheckpointSection sec(cp, csprintf("stream%d", ni));
+        Stream &stream = m_streams[ni];
+        paramIn(cp, "num_groups", stream.num_groups);
+        stream.rng.unserializeSection(cp, "rng");
+    }
+}
+
+bool
+MulticastGroupGenerator::appliesTo(int vnet) const
+{
+    return std::find(m_vnets.begin(), m_vnets.end(), vnet) != m_vnets.end();
+}
+
+void
+MulticastGroupGenerator::expand(NetDest &dest, int ni)
+{
+    MachineType mtype = dest.getMachineTypeFromNetDest();
+    if (mtype == MachineType_NUM)
+        return;
+
+    NodeID orig_dest = dest.smallestElement(mtype).num;
+    int num_machines = MachineType_base_count(mtype);
+
+    assert(ni < m_streams.size());
+    Stream &stream = m_streams[ni];
+    std::vector<NodeID> group =
+        pickGroup(orig_dest, num_machines, ni, stream);
+    stream.num_groups++;
+    if (m_record)
+        record(ni, group);
+
+    for (NodeID member : group) {
+        fatal_if(member >= num_machines, "%s: there is no %s %d "
+                 "(only %d machines of that type).", name(),
+                 MachineType_to_string(mtype), member, num_machines);
+        dest.add((MachineID) {mtype, member});
+    }
+}
+
+void
+MulticastGroupGenerator::record(int ni, const std::vector<NodeID> &group)
+{
+    std::lock_guard<std::mutex> lock(m_record_mutex);
+    std::ostream &os = *m_record->stream();
+    writeWord(os, ni);
+    writeWord(os, group.size());
+    for (NodeID member : group)
+        writeWord(os, member);
+}
+
+void
+MulticastGroupGenerator::sample(Random &rng,
+                                std::vector<NodeID> &candidates, int num,
+                                std::vector<NodeID> &group)
+{
+    // Partial Fisher-Yates shuffle: no machine is picked twice
+    num = std::min<int>(num, candidates.size());
+    for (int i = 0; i < num; i++) {
+        int j = rng.random<int>(i, candidates.size() - 1);
+        std::swap(candidates[i], candidates[j]);
+        group.push_back(candidates[i]);
+    }
+}
+
+std::vector<NodeID>
+MulticastGroupGenerator::parseGroup(const std::string &str) const
+{
+    std::vector<NodeID> group;
+    std::istringstream iss(str);
+    std::string token;
+    while (iss >> token) {
+        char *end;
+        unsigned long member = std::strtoul(token.c_str(), &end, 10);
+        fatal_if(*end != '\0', "%s: invalid machine index '%s' in "
+                 "multicast group '%s'.", name(), token, str);
+        group.push_back(member);
+    }
+    return group;
+}
+
+FixedMulticastGroups::FixedMulticastGroups(const Params &p)
+    : MulticastGroupGenerator(p)
+{
+    for (const auto &group : p.groups) {
+        m_groups.push_back(parseGroup(group));
+    }
+    fatal_if(m_groups.empty(), "%s: no multicast groups given.", name());
+}
+
+std::vector<NodeID>
+FixedMulticastGroups::pickGroup(NodeID dest, int num_machines, int ni,
+                                Stream &stream)
+{
+    return m_groups[stream.num_groups % m_groups.size()];
+}
+
+UniformMulticastGroups::UniformMulticastGroups(const Params &p)
+    : MulticastGroupGenerator(p), m_fan_out(p.fan_out)
+{
+    fatal_if(m_fan_out < 1, "%s: fan_out must be at least 1.", name());
+}
+
+std::vector<NodeID>
+UniformMulticastGroups::pickGroup(NodeID dest, int num_machines, int ni,
+                                  Stream &stream)
+{
+    std::vector<NodeID> candidates;
+    for (NodeID m = 0; m < num_machines; m++) {
+        if (m != dest)
+            candidates.push_back(m);
+    }
+
+    std::vector<NodeID> group;
+    sample(stream.rng, candidates, m_fan_out - 1, group);
+    return group;
+}
+
+ClusteredMulticastGroups::ClusteredMulticastGroups(const Params &p)
+    : MulticastGroupGenerator(p), m_fan_out(p.fan_out),
+      m_radius(p.radius), m_num_rows(std::max(p.num_rows, 1))
+{
+    fatal_if(m_fan_out < 1, "%s: fan_out must be at least 1.", name());
+}
+
+std::vector<NodeID>
+ClusteredMulticastGroups::pickGroup(NodeID dest, int num_machines, int ni,
+                                    Stream &stream)
+{
+    int num_cols = divCeil(num_machines, m_num_rows);
+    int dest_x = dest % num_cols;
+    int dest_y = dest / num_cols;
+
+    std::vector<NodeID> candidates;
+    for (NodeID m = 0; m < num_machines; m++) {
+        int distance = std::abs((int)(m % num_cols) - dest_x) +
+                       std::abs((int)(m / num_cols) - dest_y);
+        if (m != dest && distance <= m_radius)
+            candidates.push_back(m);
+    }
+
+    std::vector<NodeID> group;
+    sample(stream.rng, candidates, m_fan_out - 1, group);
+    return group;
+}
+
+TraceMulticastGroups::TraceMulticastGroups(const Params &p)
+    : MulticastGroupGenerator(p)
+{
+    std::ifstream trace(p.trace_file);
+    fatal_if(!trace, "%s: could not open multicast group trace %s.",
+             name(), p.trace_file);
+
+    std::string line;
+    while (std::getline(trace, line)) {
+        // Skip comments and blank lines
+        line = line.substr(0, line.find('#'));
+        std::vector<NodeID> group = parseGroup(line);
+        if (!group.empty())
+            m_groups.push_back(group);
+    }
+    fatal_if(m_groups.empty(), "%s: no multicast groups in %s.", name(),
+             p.trace_file);
+}
+
+std::vector<NodeID>
+TraceMulticastGroups::pickGroup(NodeID dest, int num_machines, int ni,
+                                Stream &stream)
+{
+    return m_groups[stream.num_groups % m_groups.size()];
+}
+
+ReplayMulticastGroups::ReplayMulticastGroups(const Params &p)
+    : MulticastGroupGenerator(p)
+{
+    std::ifstream replay(p.replay_file, std::ios::binary);
+    fatal_if(!replay, "%s: could not open multicast group record %s.",
+             name(), p.replay_file);
+
+    char magic[sizeof(recordMagic)];
+    uint16_t version = 0, num_nis = 0;
+    replay.read(magic, sizeof(magic));
+    fatal_if(!replay ||
+             !std::equal(magic, magic + sizeof(magic), recordMagic) ||
+             !readWord(replay, version) || version != recordVersion ||
+             !readWord(replay, num_nis),
+             "%s: %s is not a multicast group record.", name(),
+             p.replay_file);
+
+    m_groups.resize(num_nis);
+    uint16_t ni, size;
+    while (readWord(replay, ni)) {
+        fatal_if(ni >= num_nis || !readWord(replay, size),
+                 "%s: %s is corrupt.", name(), p.replay_file);
+
+        std::vector<NodeID> group(size);
+        for (NodeID &member : group) {
+            uint16_t word;
+            fatal_if(!readWord(replay, word), "%s: %s is truncated.",
+                     name(), p.replay_file);
+            member = word;
+        }
+        m_groups[ni].push_back(std::move(group));
+    }
+}
+
+std::vector<NodeID>
+ReplayMulticastGroups::pickGroup(NodeID dest, int num_machines, int ni,
+                                 Stream &stream)
+{
+    fatal_if(ni >= m_groups.size() || m_groups[ni].empty(),
+             "%s: no multicast groups recorded for NI %d.", name(), ni);
+    const std::vector<std::vector<NodeID>> &groups = m_groups[ni];
+    return groups[stream.num_groups % groups.size()];
+}
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_0_MULTICASTGROUPGENERATOR_HH__
+#define __MEM_RUBY_NETWORK_GARNET_0_MULTICASTGROUPGENERATOR_HH__
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "base/output.hh"
+#include "base/random.hh"
+#include "mem/ruby/common/NetDest.hh"
+#include "mem/ruby/common/TypeDefines.hh"
+#include "params/ClusteredMulticastGroups.hh"
+#include "params/FixedMulticastGroups.hh"
+#include "params/MulticastGroupGenerator.hh"
+#include "params/ReplayMulticastGroups.hh"
+#include "params/TraceMulticastGroups.hh"
+#include "params/UniformMulticastGroups.hh"
+#include "sim/sim_object.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+// A MulticastGroupGenerator turns the destination of a message injected
+// into the network into a multicast group of machines of the same type.
+// Groups are given as machine indices within that type; the original
+// destination of the message is always part of the group.
+//
+// Each NI picks its groups from its own stream, seeded from the seed of
+// the generator and the NI. The groups of an NI therefore only depend on
+// the messages it injects, not on the order in which the NIs inject or
+// on the other users of random numbers. The groups can also be recorded
+// to a binary file, to be replayed by ReplayMulticastGroups.
+class MulticastGroupGenerator : public SimObject
+{
+  public:
+    typedef MulticastGroupGeneratorParams Params;
+    MulticastGroupGenerator(const Params &p);
+
+    // Set up the streams of the NIs of the network
+    void initStreams(int num_nis);
+
+    // Whether the messages on this vnet are turned into groups
+    bool appliesTo(int vnet) const;
+
+    // Add the members of a new group to the destination of a message
+    // injected by NI ni
+    void expand(NetDest &dest, int ni);
+
+    // The streams are restored along with the network, see
+    // GarnetNetwork::restoreState
+    void serialize(CheckpointOut &cp) const override;
+    void restoreState(CheckpointIn &cp);
+
+  protected:
+    struct Stream
+    {
+        Random rng;
+        // Groups picked so far
+        uint64_t num_groups = 0;
+    };
+
+    // Machine indices of the group for a message to machine dest,
+    // among num_machines machines of its type, injected by NI ni
+    virtual std::vector<NodeID> pickGroup(NodeID dest, int num_machines,
+                                          int ni, Stream &stream) = 0;
+
+    // Move num random elements of candidates to the group
+    static void sample(Random &rng, std::vector<NodeID> &candidates,
+                       int num, std::vector<NodeID> &group);
+
+    // Parse a space-separated list of machine indices
+    std::vector<NodeID> parseGroup(const std::string &str) const;
+
+  private:
+    void record(int ni, const std::vector<NodeID> &group);
+
+    std::vector<int> m_vnets;
+    const uint32_t m_seed;
+    std::vector<Stream> m_streams;
+
+    // Binary record of the groups, written by the NIs of all the
+    // event queues
+    OutputStream *m_record;
+    std::mutex m_record_mutex;
+};
+
+// Groups given in the configuration, used in turn
+class FixedMulticastGroups : public MulticastGroupGenerator
+{
+  public:
+    typedef FixedMulticastGroupsParams Params;
+    FixedMulticastGroups(const Params &p);
+
+  protected:
+    std::vector<NodeID> pickGroup(NodeID dest, int num_machines, int ni,
+                                  Stream &stream) override;
+
+  private:
+    std::vector<std::vector<NodeID>> m_groups;
+};
+
+// fan_out distinct machines chosen uniformly at random
+class UniformMulticastGroups : public MulticastGroupGenerator
+{
+  public:
+    typedef UniformMulticastGroupsParams Params;
+    UniformMulticastGroups(const Params &p);
+
+  protected:
+    std::vector<NodeID> pickGroup(NodeID dest, int num_machines, int ni,
+                                  Stream &stream) override;
+
+  private:
+    const int m_fan_out;
+};
+
+// fan_out distinct machines chosen at random among those within radius
+// hops of the original destination, with the machines laid out in
+// num_rows rows like the routers of a mesh
+class ClusteredMulticastGroups : public MulticastGroupGenerator
+{
+  public:
+    typedef ClusteredMulticastGroupsParams Params;
+    ClusteredMulticastGroups(const Params &p);
+
+  protected:
+    std::vector<NodeID> pickGroup(NodeID dest, int num_machines, int ni,
+                                  Stream &stream) override;
+
+  private:
+    const int m_fan_out;
+    const int m_radius;
+    const int m_num_rows;
+};
+
+// Groups read from a trace file, one per line, used in turn
+class TraceMulticastGroups : public MulticastGroupGenerator
+{
+  public:
+    typedef TraceMulticastGroupsParams Params;
+    TraceMulticastGroups(const Params &p);
+
+  protected:
+    std::vector<NodeID> pickGroup(NodeID dest, int num_machines, int ni,
+                                  Stream &stream) override;
+
+  private:
+    std::vector<std::vector<NodeID>> m_groups;
+};
+
+// Groups recorded by another generator, given to each NI in the order
+// it picked them
+class ReplayMulticastGroups : public MulticastGroupGenerator
+{
+  public:
+    typedef ReplayMulticastGroupsParams Params;
+    ReplayMulticastGroups(const Params &p);
+
+  protected:
+    std::vector<NodeID> pickGroup(NodeID dest, int num_machines, int ni,
+                                  Stream &stream) override;
+
+  private:
+    // Indexed by [ni][group]
+    std::vector<std::vector<std::vector<NodeID>>> m_groups;
+};
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_GARNET_0_MULTICASTGROUPGENERATOR_HH__
@@ -0,0 +1,102 @@
+# Copyright (c) 2026 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from m5.params import *
+from m5.proxy import *
+from m5.SimObject import SimObject
+
+
+class MulticastGroupGenerator(SimObject):
+    type = "MulticastGroupGenerator"
+    abstract = True
+    cxx_class = "gem5::ruby::garnet::MulticastGroupGenerator"
+    cxx_header = "mem/ruby/network/garnet/MulticastGroupGenerator.hh"
+
+    vnets = VectorParam.Int(
+        [0], "vnets whose messages are turned into multicast groups"
+    )
+    seed = Param.UInt32(1, "seed of the random streams of the NIs")
+    record_file = Param.String(
+        "",
+        "record the groups to this binary file in the output directory, "
+        "to be replayed by ReplayMulticastGroups",
+    )
+
+
+class FixedMulticastGroups(MulticastGroupGenerator):
+    type = "FixedMulticastGroups"
+    cxx_class = "gem5::ruby::garnet::FixedMulticastGroups"
+    cxx_header = "mem/ruby/network/garnet/MulticastGroupGenerator.hh"
+
+    groups = VectorParam.String(
+        "groups used in turn, each a space-separated list of "
+        "machine indices, e.g. '3 4 7 11'"
+    )
+
+
+class UniformMulticastGroups(MulticastGroupGenerator):
+    type = "UniformMulticastGroups"
+    cxx_class = "gem5::ruby::garnet::UniformMulticastGroups"
+    cxx_header = "mem/ruby/network/garnet/MulticastGroupGenerator.hh"
+
+    fan_out = Param.UInt32(8, "number of destinations in a group")
+
+
+class ClusteredMulticastGroups(MulticastGroupGenerator):
+    type = "ClusteredMulticastGroups"
+    cxx_class = "gem5::ruby::garnet::ClusteredMulticastGroups"
+    cxx_header = "mem/ruby/network/garnet/MulticastGroupGenerator.hh"
+
+    fan_out = Param.UInt32(8, "number of destinations in a group")
+    radius = Param.UInt32(
+        2, "maximum mesh distance from the original destination"
+    )
+    num_rows = Param.Int(
+        Parent.num_rows,
+        "rows the machines are laid out in (0: a single row)",
+    )
+
+
+class TraceMulticastGroups(MulticastGroupGenerator):
+    type = "TraceMulticastGroups"
+    cxx_class = "gem5::ruby::garnet::TraceMulticastGroups"
+    cxx_header = "mem/ruby/network/garnet/MulticastGroupGenerator.hh"
+
+    trace_file = Param.String(
+        "file with one group per line as a space-separated list of "
+        "machine indices; groups are used in turn"
+    )
+
+
+class ReplayMulticastGroups(MulticastGroupGenerator):
+    type = "ReplayMulticastGroups"
+    cxx_class = "gem5::ruby::garnet::ReplayMulticastGroups"
+    cxx_header = "mem/ruby/network/garnet/MulticastGroupGenerator.hh"
+
+    replay_file = Param.String(
+        "groups recorded with record_file; each NI is given the groups "
+        "it picked when they were recorded, in turn"
+    )
@@ -32,9 +32,12 @@
 
 #include "mem/ruby/network/garnet/NetworkBridge.hh"
 
+#include <algorithm>
 #include <cmath>
 
+#include "base/cprintf.hh"
 #include "debug/RubyNetwork.hh"
+#include "mem/ruby/network/garnet/FlitPool.hh"
 #include "params/GarnetIntLink.hh"
 
 namespace gem5
@@ -201,7 +204,7 @@ NetworkBridge::flitisizeAndSend(flit *t_flit)
                 scheduleFlit(fl, serDesLatency);
             }
             // Delete this flit, new flit is sent in any case
-            delete t_flit;
+            FlitPool::dispose(t_flit);
         } else {
             // Serialize
             DPRINTF(RubyNetwork, "Serializing flit :%d -----> %d "
@@ -247,7 +250,7 @@ NetworkBridge::flitisizeAndSend(flit *t_flit)
                 coBridge->neutralize(vc, flitPossible);
             }
             // Delete this flit, new flit is sent in any case
-            delete t_flit;
+            FlitPool::dispose(t_flit);
         }
         return;
     }
@@ -255,6 +258,43 @@ NetworkBridge::flitisizeAndSend(flit *t_flit)
     // If only CDC is enabled schedule it
     scheduleFlit(t_flit, Cycles(0));
 }
+void
+NetworkBridge::serialize(CheckpointOut &cp) const
+{
+    NetworkLink::serialize(cp);
+
+    // Packets being (de)serialized
+    SERIALIZE_SCALAR(lastScheduledAt);
+    SERIALIZE_CONTAINER(lenBuffer);
+    SERIALIZE_CONTAINER(sizeSent);
+    SERIALIZE_CONTAINER(flitsSent);
+    for (int vc = 0; vc < (int)extraCredit.size(); vc++) {
+        std::queue<int> credits = extraCredit[vc];
+        std::vector<int> extra_credit;
+        for (; !credits.empty(); credits.pop())
+            extra_credit.push_back(credits.front());
+        arrayParamOut(cp, csprintf("extraCredit%d", vc), extra_credit);
+    }
+}
+
+void
+NetworkBridge::restoreState(CheckpointIn &cp, GarnetNetwork *net)
+{
+    NetworkLink::restoreState(cp, net);
+
+    UNSERIALIZE_SCALAR(lastScheduledAt);
+    UNSERIALIZE_CONTAINER(lenBuffer);
+    UNSERIALIZE_CONTAINER(sizeSent);
+    UNSERIALIZE_CONTAINER(flitsSent);
+    for (int vc = 0; vc < (int)extraCredit.size(); vc++) {
+        std::vector<int> extra_credit;
+        arrayParamIn(cp, csprintf("extraCredit%d", vc), extra_credit);
+        extraCredit[vc] = std::queue<int>();
+        for (int credits : extra_credit)
+            extraCredit[vc].push(credits);
+    }
+}
+
 void
 NetworkBridge::wakeup()
 {
@@ -266,9 +306,10 @@ NetworkBridge::wakeup()
         flitisizeAndSend(t_flit);
     }
 
-    // Reschedule in case there is a waiting flit.
+    // Reschedule for the cycle the waiting flit can leave.
     if (!link_srcQueue->isEmpty()) {
-        scheduleEvent(Cycles(1));
+        scheduleEventAbsolute(std::max(clockEdge(Cycles(1)),
+            link_srcQueue->peekTopFlit()->get_time()));
     }
 }
 
@@ -71,6 +71,9 @@ class NetworkBridge: public CreditLink
     void flitisizeAndSend(flit *t_flit);
     void setVcsPerVnet(uint32_t consumerVcs);
 
+    void serialize(CheckpointOut &cp) const override;
+    void restoreState(CheckpointIn &cp, GarnetNetwork *net) override;
+
   protected:
     // Pointer to co-existing bridge
     // CreditBridge for Network Bridge and vice versa
@@ -32,15 +32,20 @@
 
 #include "mem/ruby/network/garnet/NetworkInterface.hh"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <functional>
+#include <limits>
 
 #include "base/cast.hh"
-#include "base/random.hh"
+#include "base/cprintf.hh"
 #include "debug/GarnetMulticast.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/MessageBuffer.hh"
 #include "mem/ruby/network/garnet/Credit.hh"
+#include "mem/ruby/network/garnet/FlitPool.hh"
+#include "mem/ruby/network/garnet/MulticastGroupGenerator.hh"
 #include "mem/ruby/network/garnet/flitBuffer.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
 
@@ -55,15 +60,43 @@ namespace garnet
 
 NetworkInterface::NetworkInterface(const Params &p)
   : ClockedObject(p), Consumer(this), m_id(p.id),
-    m_virtual_networks(p.virt_nets), m_vc_per_vnet(0),
+    m_partition(p.eventq_index), m_virtual_networks(p.virt_nets),
+    m_vc_per_vnet(0),
     m_vc_allocator(m_virtual_networks, 0),
     m_deadlock_threshold(p.garnet_deadlock_threshold),
     m_multicast_mac_cycles(p.multicast_mac_cycles),
     m_multicast_verify_cycles(p.multicast_verify_cycles),
+    m_siphash_cycles(p.siphash_cycles),
+    m_siphash_cycles_per_byte(p.siphash_cycles_per_byte),
+    m_siphash_tag_bytes(p.siphash_tag_bytes),
+    m_auth_tags_in_flits(p.auth_tags_in_flits),
+    m_multiauth_max_dests(p.multiauth_max_dests),
+    m_multiauth_tag_bytes(p.multiauth_tag_bytes),
+    m_hybrid_multicast(p.hybrid_multicast),
+    m_straggler_hops(p.straggler_hops),
+    m_hybrid_load_weight(p.hybrid_load_weight),
     vc_busy_counter(m_virtual_networks, 0)
 {
     m_stall_count.resize(m_virtual_networks);
+    m_deliveries.resize(m_virtual_networks);
+    m_last_mac_ready.resize(m_virtual_networks, 0);
     niOutVcs.resize(0);
+
+    fatal_if(m_multiauth_max_dests.empty() ||
+             m_multiauth_max_dests.size() != m_multiauth_tag_bytes.size(),
+             "%s: multiauth_max_dests and multiauth_tag_bytes must have "
+             "the same, non-zero, number of entries.", name());
+    fatal_if(std::adjacent_find(m_multiauth_max_dests.begin(),
+                                m_multiauth_max_dests.end(),
+                                std::greater_equal<uint32_t>()) !=
+             m_multiauth_max_dests.end(),
+             "%s: multiauth_max_dests must be in increasing order.",
+             name());
+    fatal_if(p.mac_lanes == 0 || p.mac_pipeline_stages == 0,
+             "%s: the MAC engine needs at least one lane and stage.",
+             name());
+    m_mac_engine.init(p.mac_lanes, p.mac_pipeline_stages,
+                      p.mac_queue_depth, m_virtual_networks);
 }
 
 void
@@ -173,7 +206,9 @@ NetworkInterface::incrementStats(flit *t_flit)
             dest_queueing_delay = (curTick() - t_flit->get_dequeue_time() + cyclesToTicks(Cycles(m_multicast_verify_cycles)));
         }
         else{
-            dest_queueing_delay = (curTick() - t_flit->get_dequeue_time() + cyclesToTicks(Cycles(10)));
+            dest_queueing_delay = (curTick() - t_flit->get_dequeue_time() +
+                cyclesToTicks(Cycles(
+                    getNumberOfSpiphshCycles(t_flit->msgSize))));
         }
     } 
 
@@ -186,33 +221,129 @@ NetworkInterface::incrementStats(flit *t_flit)
         m_net_ptr->increment_received_packets(vnet);
         m_net_ptr->increment_packet_network_latency(network_delay, vnet);
         m_net_ptr->increment_packet_queueing_latency(queueing_delay, vnet);
+
+        // The message is complete once its last destination has the tail
+        const auto &delivery = t_flit->get_packet()->delivery;
+        if (delivery && --delivery->pending == 0) {
+            m_net_ptr->increment_delivered_messages(delivery->fan_out,
+                delivery->path, curTick() - delivery->issue_time);
+        }
+    }
+
+    // Unicast packets would have carried this flit through every router
+    // on the path to this destination
+    if (t_flit->is_multicast()) {
+        m_net_ptr->increment_multicast_unicast_traversals(
+            t_flit->get_hops_traversed() + 1);
     }
 
     // Hops
-    m_net_ptr->increment_total_hops(t_flit->get_route(0).hops_traversed);
+    m_net_ptr->increment_total_hops(t_flit->get_hops_traversed());
+}
+
+// Calculate the NetDest associated with a (global) NodeID
+NetDest
+NetworkInterface::nodeToNetDest(NodeID node)
+{
+    NetDest net_dest;
+    for (int m = 0; m < (int) MachineType_NUM; m++) {
+        if ((node >= MachineType_base_number((MachineType) m)) &&
+            node < MachineType_base_number((MachineType) (m+1))) {
+            net_dest.add((MachineID) {(MachineType) m, (node -
+                MachineType_base_number((MachineType) m))});
+            break;
+        }
+    }
+    return net_dest;
+}
+
+void
+NetworkInterface::init_global_id(NodeID global_id)
+{
+    m_personal_dest = nodeToNetDest(global_id);
+}
+
+// All the destinations of a message share the copy of the source NI.
+// Hand the protocol a message that is addressed to this NI only. The
+// message is copied, unless this flit holds the last reference to it:
+// the protocol modifies the messages it receives.
+MsgPtr
+NetworkInterface::ejectMessage(flit *t_flit)
+{
+    MsgPtr msg_ptr = t_flit->get_msg_ptr();
+
+    // Only this flit's packet info and msg_ptr refer to the message
+    if (t_flit->get_packet().use_count() > 1 || msg_ptr.use_count() > 2)
+        msg_ptr = msg_ptr->clone();
+
+    if (!msg_ptr->getDestination().isEqual(m_personal_dest))
+        msg_ptr->getDestination() = m_personal_dest;
+    return msg_ptr;
 }
 
 
-// The bumber of bytes in multi auth tag only depend on security strength and the number of multicast recipients (these are some pre calculated values)
+// The number of bytes in a multi-auth tag only depends on the security
+// strength and the number of multicast recipients. The sizes for the
+// configured strength are precalculated in the multiauth_* tables.
 int
-NetworkInterface::getNumberOfMultiAuthBytes(int t, int N)
-{
-    if (t==10 && N<=4){
-        return 26;
-    } else if(t==10 && N<=8){
-        return 40;
-    }else{
-        panic("Invalid t and N");
-        return 0;
+NetworkInterface::getNumberOfMultiAuthBytes(int N)
+{
+    int n = m_multiauth_max_dests.size();
+    for (int i = 0; i < n; i++) {
+        if (N <= (int)m_multiauth_max_dests[i])
+            return m_multiauth_tag_bytes[i];
     }
+
+    // Larger groups: extrapolate from the last two entries
+    int last_dests = m_multiauth_max_dests[n - 1];
+    int last_bytes = m_multiauth_tag_bytes[n - 1];
+    if (n == 1)
+        return last_bytes;
+    int dests = last_dests - m_multiauth_max_dests[n - 2];
+    int bytes = last_bytes - m_multiauth_tag_bytes[n - 2];
+    return last_bytes + divCeil((N - last_dests) * bytes, dests);
 }
 
 
-// The number of cycles required calculate siphash length tag only depend on message length in bytes
+// The number of cycles required to calculate a siphash tag only depends
+// on the message length in bytes
 int
 NetworkInterface::getNumberOfSpiphshCycles(int msgLength)
 {
-    return (int)2.5*msgLength;
+    return m_siphash_cycles +
+        (int)std::ceil(m_siphash_cycles_per_byte * msgLength);
+}
+
+// Bytes of authentication tag carried by a packet to num_dests
+// destinations, if the tags are accounted in the flits at all
+int
+NetworkInterface::getNumberOfTagBytes(int num_dests)
+{
+    if (!m_auth_tags_in_flits)
+        return 0;
+    if (num_dests > 1)
+        return getNumberOfMultiAuthBytes(num_dests);
+    return m_siphash_tag_bytes;
+}
+
+// Reserve the MAC engine for a tag of this many cycles.
+// Returns the time at which the tag is ready.
+Tick
+NetworkInterface::reserveMac(int vnet, Cycles cycles)
+{
+    Tick wait;
+    Tick ready = m_mac_engine.reserve(vnet, clockEdge(), cycles,
+                                      clockPeriod(), wait);
+    m_net_ptr->increment_mac_tags(vnet, wait);
+
+    // With several lanes a short tag can be ready before a longer one
+    // that started earlier. The packets of an ordered vnet are sent in
+    // the order their tags are ready, so keep that order.
+    if (m_net_ptr->isVNetOrdered(vnet)) {
+        ready = std::max(ready, m_last_mac_ready[vnet] + clockPeriod());
+        m_last_mac_ready[vnet] = ready;
+    }
+    return ready;
 }
 
 /*
@@ -238,6 +369,8 @@ NetworkInterface::wakeup()
     assert(curTick() == clockEdge());
     MsgPtr msg_ptr;
     Tick curTime = clockEdge();
+    // Whether a message, flit or credit moved during this wakeup
+    bool useful = false;
 
     // Checking for messages coming from the protocol
     // can pick up a message/cycle for each virtual net
@@ -251,15 +384,16 @@ NetworkInterface::wakeup()
             msg_ptr = b->peekMsgPtr();
             if (flitisizeMessage(msg_ptr, vnet)) {
                 b->dequeue(curTime);
+                useful = true;
             }
         }
     }
 
-    scheduleOutputLink();
+    useful |= scheduleOutputLink();
 
     // Check if there are flits stalling a virtual channel. Track if a
     // message is enqueued to restrict ejection to one message per cycle.
-    checkStallQueue();
+    useful |= checkStallQueue();
 
     /*********** Check the incoming flit link **********/
     DPRINTF(RubyNetwork, "Number of input ports: %d\n", inPorts.size());
@@ -268,11 +402,26 @@ NetworkInterface::wakeup()
         if (inNetLink->isReady(curTick())) {
             flit *t_flit = inNetLink->consumeLink();
             DPRINTF(RubyNetwork, "Recieved flit:%s\n", *t_flit);
+            useful = true;
             assert(t_flit->m_width == iPort->bitWidth());
+            traceFlit(TRACE_EJECT_, t_flit);
 
             int vnet = t_flit->get_vnet();
             t_flit->set_dequeue_time(curTick());
 
+            // A flit restored from a checkpoint has no message for the
+            // protocol, so it is simply dropped
+            if (t_flit->is_ghost()) {
+                bool is_tail = t_flit->get_type() == TAIL_ ||
+                    t_flit->get_type() == HEAD_TAIL_;
+                iPort->sendCredit(new Credit(t_flit->get_vc(), is_tail,
+                                             curTick()));
+                if (is_tail)
+                    m_net_ptr->increment_ghost_packets(vnet);
+                FlitPool::dispose(t_flit);
+                continue;
+            }
+
             // If a tail flit is received, enqueue into the protocol buffers
             // if space is available. Otherwise, exchange non-tail flits for
             // credits.
@@ -281,7 +430,7 @@ NetworkInterface::wakeup()
                 if (!iPort->messageEnqueuedThisCycle &&
                     outNode_ptr[vnet]->areNSlotsAvailable(1, curTime)) {
                     // Space is available. Enqueue to protocol buffer.
-                    outNode_ptr[vnet]->enqueue(t_flit->get_msg_ptr(), curTime,
+                    outNode_ptr[vnet]->enqueue(ejectMessage(t_flit), curTime,
                                                cyclesToTicks(Cycles(1)));
 
                     // Simply send a credit back since we are not buffering
@@ -291,7 +440,7 @@ NetworkInterface::wakeup()
                     iPort->sendCredit(cFlit);
                     // Update stats and delete flit pointer
                     incrementStats(t_flit);
-                    delete t_flit;
+                    FlitPool::dispose(t_flit);
                 } else {
                     // No space available- Place tail flit in stall queue and
                     // set up a callback for when protocol buffer is dequeued.
@@ -313,7 +462,7 @@ NetworkInterface::wakeup()
 
                 // Update stats and delete flit pointer.
                 incrementStats(t_flit);
-                delete t_flit;
+                FlitPool::dispose(t_flit);
             }
         }
     }
@@ -324,6 +473,7 @@ NetworkInterface::wakeup()
         CreditLink *inCreditLink = oPort->inCreditLink();
         if (inCreditLink->isReady(curTick())) {
             Credit *t_credit = (Credit*) inCreditLink->consumeLink();
+            useful = true;
             outVcState[t_credit->get_vc()].increment_credit();
             if (t_credit->is_free_signal()) {
                 outVcState[t_credit->get_vc()].setState(IDLE_,
@@ -347,12 +497,20 @@ NetworkInterface::wakeup()
                 scheduleEventAbsolute(clockEdge(Cycles(1)));
         }
     }
+
+    if (useful)
+        m_num_useful_wakeups++;
+    else
+        m_num_empty_wakeups++;
+
     checkReschedule();
 }
 
-void
+bool
 NetworkInterface::checkStallQueue()
 {
+    bool unstalled = false;
+
     // Check all stall queues.
     // There is one stall queue for each input link
     for (auto &iPort: inPorts) {
@@ -369,7 +527,7 @@ NetworkInterface::checkStallQueue()
                 // send back credits
                 if (outNode_ptr[vnet]->areNSlotsAvailable(1,
                     curTime)) {
-                    outNode_ptr[vnet]->enqueue(stallFlit->get_msg_ptr(),
+                    outNode_ptr[vnet]->enqueue(ejectMessage(stallFlit),
                         curTime, cyclesToTicks(Cycles(1)));
 
                     // Send back a credit with free signal now that the
@@ -383,7 +541,7 @@ NetworkInterface::checkStallQueue()
 
                     // Flit can now safely be deleted and removed from stall
                     // queue
-                    delete stallFlit;
+                    FlitPool::dispose(stallFlit);
                     iPort->m_stall_queue.erase(stallIter);
                     m_stall_count[vnet]--;
 
@@ -393,6 +551,7 @@ NetworkInterface::checkStallQueue()
                         outNode_ptr[vnet]->unregisterDequeueCallback();
 
                     iPort->messageEnqueuedThisCycle = true;
+                    unstalled = true;
                     break;
                 } else {
                     ++stallIter;
@@ -400,235 +559,389 @@ NetworkInterface::checkStallQueue()
             }
         }
     }
+    return unstalled;
 }
 
 // Embed the protocol message into flits
 bool
 NetworkInterface::flitisizeMessage(MsgPtr msg_ptr, int vnet)
 {
-
-    if (this->get_auth_delay() > curTick())
-    {
-        return false;/* code */
-    }
-    
-
     Message *net_msg_ptr = msg_ptr.get();
-    NetDest net_msg_dest = net_msg_ptr->getDestination();
+    NetDest &net_msg_dest = net_msg_ptr->getDestination();
 
-    // this condition for software unicast to avoid adding dummy destinations repeatedly for same packet
+    // The destination is expanded into a group once, in the message
+    // itself, before any of its packets leaves. A message that is
+    // retried for lack of a VC does not draw a new group. A message that
+    // already has several destinations, e.g. the group a traffic
+    // generator picked, is not expanded.
     if (!net_msg_dest.isUsed()) {
-
-        if(vnet == 0){
-            MachineType existing_mtype = net_msg_dest.getMachineTypeFromNetDest();
-            
-            // NodeID num_offset_to_add = (NodeID)2; 
-            // NetDest additional_dest;
-            // additional_dest.add((MachineID) {existing_mtype, num_offset_to_add});
-            // net_msg_dest.addNetDest(additional_dest);   
-
-            // NodeID offsets_to_add[] = {3, 4, 7, 11}; 
-            // int num_offsets = sizeof(offsets_to_add) / sizeof(offsets_to_add[0]);
-
-            int no_of_multicast_dest = 8;
-            NetDest additional_dest;
-            for(int i = 0; i < no_of_multicast_dest - 1; i++) {
-                int newID = random_mt.random<unsigned>(0, 15);
-                additional_dest.add((MachineID) {existing_mtype, (NodeID)newID});
-            }
-            net_msg_dest.addNetDest(additional_dest); 
-        }
+        MulticastGroupGenerator *groups = m_net_ptr->getMulticastGroups();
+        if (groups && groups->appliesTo(vnet) && net_msg_dest.count() == 1)
+            groups->expand(net_msg_dest, m_id);
+        net_msg_dest.setUsed();
     }
 
-    // gets all the destinations associated with this message.
-    std::vector<NodeID> dest_nodes = net_msg_dest.getAllDest();
+    // A message whose packets were only partly flitisized goes on as
+    // unicast to the destinations that have no packet yet
+    PendingDelivery &pending = m_deliveries[vnet];
+    std::vector<NodeID> dest_nodes = pending.delivery ? pending.dests :
+        net_msg_dest.getAllDest();
 
     // Number of flits is dependent on the link bandwidth available.
     // This is expressed in terms of bytes/cycle or the flit size
     OutputPort *oPort = getOutportForVnet(vnet);
     assert(oPort);
-    int num_flits = (int)divCeil((float) m_net_ptr->MessageSizeType_to_int(
-        net_msg_ptr->getMessageSize()), (float)oPort->bitWidth());
+    int msg_bytes =
+        m_net_ptr->MessageSizeType_to_int(net_msg_ptr->getMessageSize());
+    int payload_flits =
+        (int)divCeil((float)msg_bytes, (float)oPort->bitWidth());
 
     DPRINTF(RubyNetwork, "Message Size:%d vnet:%d bitWidth:%d\n",
         m_net_ptr->MessageSizeType_to_int(net_msg_ptr->getMessageSize()),
         vnet, oPort->bitWidth());
 
-    if (m_net_ptr->isMulticastEnabled()) {
+    MulticastPath path = UNICAST_PATH_;
+    std::vector<NodeID> stragglers;
+    if (m_net_ptr->isMulticastEnabled() && !pending.delivery) {
+        path = MULTICAST_PATH_;
+        if (m_hybrid_multicast && dest_nodes.size() > 1) {
+            path = chooseMulticastPath(vnet, msg_bytes, dest_nodes,
+                                       stragglers);
+        }
+    }
+
+    if (path == MULTICAST_PATH_) {
         DPRINTF(GarnetMulticast, "Flitisizing message as multicast. "
             "Num Destinations: %d.\n", dest_nodes.size());
+        return flitisizeMulticast(msg_ptr, vnet, dest_nodes, net_msg_dest,
+            std::make_shared<DeliveryInfo>(msg_ptr->getTime(),
+                (int)dest_nodes.size(), path));
+    }
+
+    if (path == SPLIT_PATH_) {
+        DPRINTF(GarnetMulticast, "Flitisizing message as multicast to %d "
+            "destinations and unicast to %d stragglers.\n",
+            dest_nodes.size(), stragglers.size());
+
+        NetDest cluster_dest = net_msg_dest;
+        for (NodeID destID : stragglers)
+            cluster_dest.removeNetDest(nodeToNetDest(destID));
+
+        auto split_delivery = std::make_shared<DeliveryInfo>(
+            msg_ptr->getTime(), (int)(dest_nodes.size() + stragglers.size()),
+            path);
+        if (!flitisizeMulticast(msg_ptr, vnet, dest_nodes, cluster_dest,
+                                split_delivery)) {
+            return false;
+        }
+
+        // Only the stragglers are left. Their unicast packets may take
+        // several wakeups to get their VCs and tags.
+        pending.delivery = split_delivery;
+        pending.dests = stragglers;
+        dest_nodes = stragglers;
+    }
 
-        std::vector<RouteInfo> routes(dest_nodes.size());
-	    std::vector<MsgPtr> new_msg_ptrs(dest_nodes.size());
-	
-        // this will return a free output virtual channel
-        int vc = calculateVC(vnet);
+    DPRINTF(GarnetMulticast, "Flitisizing message as multiple unicast.\n");
+    // loop to convert all multicast messages into unicast messages
+    for (int ctr = 0; ctr < dest_nodes.size(); ctr++) {
 
+        // Each packet has its own tag and needs a free output virtual
+        // channel. Without them, the destinations left wait for the
+        // next wakeup.
+        int vc = -1;
+        if (m_mac_engine.canAccept(vnet, curTick()))
+            vc = calculateVC(vnet);
         if (vc == -1) {
-            return false ;
-        }
-
-        Tick auth_delay = clockEdge(Cycles(m_multicast_mac_cycles));
-        bool is_multi_auth = true;
-        // int num_flits = (int)divCeil((float) m_net_ptr->MessageSizeType_to_int(
-        //     net_msg_ptr->getMessageSize()) + getNumberOfMultiAuthBytes(10, dest_nodes.size()), (float)oPort->bitWidth());
-
-        if (dest_nodes.size() == 1)
-        {
-            is_multi_auth = false;
-            auth_delay = clockEdge(Cycles(10));
-            // num_flits = (int)divCeil((float) m_net_ptr->MessageSizeType_to_int(
-            //     net_msg_ptr->getMessageSize()) + 8, (float)oPort->bitWidth());
-        }
-
-        // added dealy for auth delay
-        this->set_auth_delay(auth_delay);
-
-
-        for (int ctr = 0; ctr < dest_nodes.size(); ctr++) {
-	    MsgPtr new_msg_ptr = msg_ptr->clone();
-            NodeID destID = dest_nodes[ctr];
-            Message *new_net_msg_ptr = new_msg_ptr.get();
-
-            if (dest_nodes.size() > 1) {
-                NetDest personal_dest;
-                for (int m = 0; m < (int) MachineType_NUM; m++) {
-                    if ((destID >= MachineType_base_number((MachineType) m)) &&
-                        destID < MachineType_base_number((MachineType) (m+1))) {
-                        // calculating the NetDest associated with this destID
-                        personal_dest.clear();
-                        personal_dest.add((MachineID) {(MachineType) m, (destID -
-                            MachineType_base_number((MachineType) m))});
-                        new_net_msg_ptr->getDestination() = personal_dest;
-                        break;
-                    }
-                }
-                net_msg_dest.removeNetDest(personal_dest);
-                // removing the destination from the original message to reflect
-                // that a message with this particular destination has been
-                // flitisized and an output vc is acquired
-                net_msg_ptr->getDestination().removeNetDest(personal_dest);
+            if (pending.delivery) {
+                pending.dests.assign(dest_nodes.begin() + ctr,
+                                     dest_nodes.end());
             }
+            return false;
+        }
 
-            // Embed Route into the flits
-            // NetDest format is used by the routing table
-            // Custom routing algorithms just need destID
-            routes[ctr].vnet = vnet;
-            routes[ctr].net_dest = new_net_msg_ptr->getDestination();
-            routes[ctr].src_ni = m_id;
-            routes[ctr].src_router = oPort->routerID();
-            routes[ctr].dest_ni = destID;
-            routes[ctr].dest_router = m_net_ptr->get_router_id(destID, vnet);
-
-	        new_msg_ptrs[ctr] = new_msg_ptr;
-	    
-            // initialize hops_traversed to -1
-            // so that the first router increments it to 0
-            routes[ctr].hops_traversed = -1;
+        // The delivery is kept until the last destination has its packet
+        if (!pending.delivery) {
+            pending.delivery = std::make_shared<DeliveryInfo>(
+                msg_ptr->getTime(), (int)dest_nodes.size(), UNICAST_PATH_);
         }
+        std::shared_ptr<DeliveryInfo> &delivery = pending.delivery;
+
+        // Each destination gets its own siphash tag
+        Tick auth_delay = reserveMac(vnet,
+            Cycles(getNumberOfSpiphshCycles(msg_bytes)));
+        int num_flits = (int)divCeil(
+            (float)(msg_bytes + getNumberOfTagBytes(1)),
+            (float)oPort->bitWidth());
+
+        NodeID destID = dest_nodes[ctr];
+        NetDest personal_dest = nodeToNetDest(destID);
+
+        // The message is shared by the unicast packets to each of its
+        // destinations. The destination NI materializes its own copy.
+
+        // Embed Route into the flits
+        // NetDest format is used by the routing table
+        // Custom routing algorithms just need destID
+
+        auto packet = std::make_shared<PacketInfo>();
+        packet->msg_ptr = msg_ptr;
+        packet->delivery = delivery;
+
+        RouteInfo &route = packet->route;
+        route.vnet = vnet;
+        route.net_dest = personal_dest;
+        route.src_ni = m_id;
+        route.src_router = oPort->routerID();
+        route.dest_ni = destID;
+        route.dest_router = m_net_ptr->get_router_id(destID, vnet);
+
+        DestMask dest_mask;
+        dest_mask.add(m_net_ptr->getLocalNodeID(destID));
 
         m_net_ptr->increment_injected_packets(vnet);
-        for (auto route : routes)
-            m_net_ptr->update_traffic_distribution(route);
-        int packet_id = m_net_ptr->getNextPacketID();
+        if (delivery->fan_out > 1)
+            m_net_ptr->increment_path_destinations(UNICAST_PATH_, 1);
+        m_net_ptr->increment_injected_tag_flits(vnet,
+            num_flits - payload_flits);
+        m_net_ptr->update_traffic_distribution(route.src_router,
+            route.dest_router, vnet);
+        int packet_id = getNextPacketID();
+        FlitPool *pool = m_net_ptr->getFlitPool(m_partition);
         for (int i = 0; i < num_flits; i++) {
             m_net_ptr->increment_injected_flits(vnet);
-            flit *fl = new flit(packet_id,
-                i, vc, vnet, routes, num_flits, dest_nodes.size(), new_msg_ptrs,
-                m_net_ptr->MessageSizeType_to_int(
-                net_msg_ptr->getMessageSize()),
-                oPort->bitWidth(), auth_delay);
-            fl->set_is_multiauth(is_multi_auth);
+            flit *fl = pool->create(packet_id,
+                i, vc, vnet, packet, dest_mask, num_flits, msg_bytes,
+                oPort->bitWidth(),auth_delay);
+
             fl->set_src_delay(auth_delay - msg_ptr->getTime());
+            if (i == 0)
+                traceFlit(TRACE_ENQUEUE_, fl, msg_ptr->getTime());
             niOutVcs[vc].insert(fl);
         }
 
         m_ni_out_vcs_enqueue_time[vc] = auth_delay;
         outVcState[vc].setState(ACTIVE_, auth_delay);
+    }
+    pending = PendingDelivery();
+    return true ;
+}
+
+// Send the message to dest_nodes as one packet, signed with a multi-auth
+// tag if there are several of them
+bool
+NetworkInterface::flitisizeMulticast(MsgPtr msg_ptr, int vnet,
+                                     const std::vector<NodeID> &dest_nodes,
+                                     const NetDest &dest,
+                                     std::shared_ptr<DeliveryInfo> delivery)
+{
+    OutputPort *oPort = getOutportForVnet(vnet);
+    int msg_bytes =
+        m_net_ptr->MessageSizeType_to_int(msg_ptr->getMessageSize());
+    int payload_flits =
+        (int)divCeil((float)msg_bytes, (float)oPort->bitWidth());
+
+    // The tags of this vnet cannot be queued in the MAC engine
+    if (!m_mac_engine.canAccept(vnet, curTick()))
+        return false;
+
+    // this will return a free output virtual channel
+    int vc = calculateVC(vnet);
+
+    if (vc == -1) {
+        return false ;
+    }
+
+    // A single destination is signed with SipHash
+    bool is_multi_auth = dest_nodes.size() > 1;
+    Cycles mac_cycles = Cycles(is_multi_auth ? m_multicast_mac_cycles :
+        getNumberOfSpiphshCycles(msg_bytes));
+    Tick auth_delay = reserveMac(vnet, mac_cycles);
+
+    int num_flits = (int)divCeil(
+        (float)(msg_bytes + getNumberOfTagBytes(dest_nodes.size())),
+        (float)oPort->bitWidth());
+
+    // Embed Route into the flits
+    // A single packet carries all the destinations as a DestMask
+    // and the routers replicate it along the multicast tree.
+    // All the flits and branches share the packet info; each
+    // destination NI materializes its own message upon ejection.
+    auto packet = std::make_shared<PacketInfo>();
+    packet->msg_ptr = msg_ptr;
+    packet->delivery = delivery;
+
+    RouteInfo &route = packet->route;
+    route.vnet = vnet;
+    route.net_dest = dest;
+    route.src_ni = m_id;
+    route.src_router = oPort->routerID();
+    if (dest_nodes.size() == 1) {
+        route.dest_ni = dest_nodes[0];
+        route.dest_router =
+            m_net_ptr->get_router_id(dest_nodes[0], vnet);
     } else {
-        DPRINTF(GarnetMulticast, "Flitisizing message as multiple unicast.\n");
-        // loop to convert all multicast messages into unicast messages
-        for (int ctr = 0; ctr < dest_nodes.size(); ctr++) {
+        route.dest_ni = -1;
+        route.dest_router = -1;
+    }
 
-            // this will return a free output virtual channel
-            int vc = calculateVC(vnet);
+    DestMask dest_mask;
+    for (auto destID : dest_nodes) {
+        dest_mask.add(m_net_ptr->getLocalNodeID(destID));
+        m_net_ptr->update_traffic_distribution(route.src_router,
+            m_net_ptr->get_router_id(destID, vnet), vnet);
+    }
 
-            if (vc == -1) {
-                net_msg_dest.setUsed();
-                net_msg_ptr->getDestination().setUsed();
-                return false ;
-            }
+    m_net_ptr->increment_injected_packets(vnet);
+    if (delivery->fan_out > 1) {
+        m_net_ptr->increment_path_destinations(MULTICAST_PATH_,
+                                               dest_nodes.size());
+    }
+    m_net_ptr->increment_injected_tag_flits(vnet,
+        num_flits - payload_flits);
+    int packet_id = getNextPacketID();
+    FlitPool *pool = m_net_ptr->getFlitPool(m_partition);
+    for (int i = 0; i < num_flits; i++) {
+        m_net_ptr->increment_injected_flits(vnet);
+        flit *fl = pool->create(packet_id,
+            i, vc, vnet, packet, dest_mask, num_flits, msg_bytes,
+            oPort->bitWidth(), auth_delay);
+        fl->set_is_multiauth(is_multi_auth);
+        fl->set_src_delay(auth_delay - msg_ptr->getTime());
+        if (i == 0)
+            traceFlit(TRACE_ENQUEUE_, fl, msg_ptr->getTime());
+        niOutVcs[vc].insert(fl);
+    }
 
-            // added dealy for auth delay
-            this->set_auth_delay(clockEdge(Cycles(10*(ctr+1))));
-            // add 8 bytes to the message length for siphash tag
-            // int num_flits = (int)divCeil((float) m_net_ptr->MessageSizeType_to_int(
-            //     net_msg_ptr->getMessageSize()) + 8, (float)oPort->bitWidth());
-
-            MsgPtr new_msg_ptr = msg_ptr->clone();
-            NodeID destID = dest_nodes[ctr];
-
-            Message *new_net_msg_ptr = new_msg_ptr.get();
-            if (dest_nodes.size() > 1) {
-                NetDest personal_dest;
-                for (int m = 0; m < (int) MachineType_NUM; m++) {
-                    if ((destID >= MachineType_base_number((MachineType) m)) &&
-                        destID < MachineType_base_number((MachineType) (m+1))) {
-                        // calculating the NetDest associated with this destID
-                        personal_dest.clear();
-                        personal_dest.add((MachineID) {(MachineType) m, (destID -
-                            MachineType_base_number((MachineType) m))});
-                        new_net_msg_ptr->getDestination() = personal_dest;
-                        break;
-                    }
-                }
-                net_msg_dest.removeNetDest(personal_dest);
-                // removing the destination from the original message to reflect
-                // that a message with this particular destination has been
-                // flitisized and an output vc is acquired
-                net_msg_ptr->getDestination().removeNetDest(personal_dest);
-            }
+    m_ni_out_vcs_enqueue_time[vc] = auth_delay;
+    outVcState[vc].setState(ACTIVE_, auth_delay);
+    return true;
+}
 
-            // Embed Route into the flits
-            // NetDest format is used by the routing table
-            // Custom routing algorithms just need destID
-
-            std::vector<RouteInfo> routes(1);
-            routes[0].vnet = vnet;
-            routes[0].net_dest = new_net_msg_ptr->getDestination();
-            routes[0].src_ni = m_id;
-            routes[0].src_router = oPort->routerID();
-            routes[0].dest_ni = destID;
-            routes[0].dest_router = m_net_ptr->get_router_id(destID, vnet);
-
-	        std::vector<MsgPtr> new_msg_ptrs(1);
-	        new_msg_ptrs[0] = new_msg_ptr;
-	    
-            // initialize hops_traversed to -1
-            // so that the first router increments it to 0
-            routes[0].hops_traversed = -1;
-
-            m_net_ptr->increment_injected_packets(vnet);
-            m_net_ptr->update_traffic_distribution(routes[0]);
-            int packet_id = m_net_ptr->getNextPacketID();
-            Tick auth_delay = clockEdge(Cycles(10*(ctr+1)));
-            for (int i = 0; i < num_flits; i++) {
-                m_net_ptr->increment_injected_flits(vnet);
-                flit *fl = new flit(packet_id,
-                    i, vc, vnet, routes, num_flits, 1, new_msg_ptrs,
-                    m_net_ptr->MessageSizeType_to_int(
-                    net_msg_ptr->getMessageSize()),
-                    oPort->bitWidth(),auth_delay);
-
-                fl->set_src_delay(auth_delay - msg_ptr->getTime());
-                niOutVcs[vc].insert(fl);
+// Choose the cheapest way, by estimatePathCost, to send a message to
+// dest_nodes: one multicast packet, one unicast packet per destination,
+// or a split where the stragglers get unicast packets. A straggler is a
+// destination farther than straggler_hops from all the others. For a
+// split, the stragglers are moved from dest_nodes to stragglers.
+MulticastPath
+NetworkInterface::chooseMulticastPath(int vnet, int msg_bytes,
+                                      std::vector<NodeID> &dest_nodes,
+                                      std::vector<NodeID> &stragglers)
+{
+    std::vector<int> routers;
+    for (NodeID destID : dest_nodes)
+        routers.push_back(m_net_ptr->get_router_id(destID, vnet));
+
+    std::vector<bool> is_straggler(routers.size(), true);
+    std::vector<int> cluster_routers, straggler_routers;
+    for (int i = 0; i < routers.size(); i++) {
+        for (int j = 0; j < routers.size() && is_straggler[i]; j++) {
+            if (j != i && m_net_ptr->getRouterDistance(routers[i],
+                              routers[j]) <= m_straggler_hops) {
+                is_straggler[i] = false;
             }
+        }
+        if (is_straggler[i])
+            straggler_routers.push_back(routers[i]);
+        else
+            cluster_routers.push_back(routers[i]);
+    }
+
+    double multicast = estimatePathCost(vnet, msg_bytes, routers, {});
+    double unicast = estimatePathCost(vnet, msg_bytes, {}, routers);
+    double split = std::numeric_limits<double>::max();
+    if (!cluster_routers.empty() && !straggler_routers.empty()) {
+        split = estimatePathCost(vnet, msg_bytes, cluster_routers,
+                                 straggler_routers);
+    }
 
-            m_ni_out_vcs_enqueue_time[vc] = auth_delay;
-            outVcState[vc].setState(ACTIVE_, auth_delay);
+    DPRINTF(GarnetMulticast, "Path costs to %d destinations: multicast "
+            "%.1f, unicast %.1f, split with %d stragglers %.1f\n",
+            dest_nodes.size(), multicast, unicast,
+            straggler_routers.size(), split);
+
+    if (multicast <= unicast && multicast <= split)
+        return MULTICAST_PATH_;
+    if (unicast <= split)
+        return UNICAST_PATH_;
+
+    std::vector<NodeID> clustered;
+    for (int i = 0; i < dest_nodes.size(); i++) {
+        if (is_straggler[i])
+            stragglers.push_back(dest_nodes[i]);
+        else
+            clustered.push_back(dest_nodes[i]);
+    }
+    dest_nodes = clustered;
+    return SPLIT_PATH_;
+}
+
+// Estimated cost of sending a message to the multicast_routers with one
+// multicast packet and to the unicast_routers with unicast packets: the
+// cycles until the last destination has verified its tag, counting one
+// cycle per hop, plus hybrid_load_weight cycles per flit hop added to
+// the network when all the output VCs of the vnet are busy.
+double
+NetworkInterface::estimatePathCost(int vnet, int msg_bytes,
+                                   const std::vector<int> &multicast_routers,
+                                   const std::vector<int> &unicast_routers)
+{
+    OutputPort *oPort = getOutportForVnet(vnet);
+    int src = oPort->routerID();
+    int siphash_cycles = getNumberOfSpiphshCycles(msg_bytes);
+
+    // The tags, in the order they would be reserved
+    std::vector<Cycles> tags;
+    if (!multicast_routers.empty())
+        tags.push_back(Cycles(m_multicast_mac_cycles));
+    tags.insert(tags.end(), unicast_routers.size(), Cycles(siphash_cycles));
+    std::vector<Cycles> ready =
+        m_mac_engine.estimate(clockEdge(), tags, clockPeriod());
+
+    int busy_vcs = 0;
+    for (int vc = vnet * m_vc_per_vnet; vc < (vnet + 1) * m_vc_per_vnet;
+         vc++) {
+        if (!outVcState[vc].isInState(IDLE_, curTick()))
+            busy_vcs++;
+    }
+    double load = m_hybrid_load_weight * busy_vcs / m_vc_per_vnet;
+
+    // The packets leave the NI one flit per cycle once their tag is ready
+    uint64_t sent = 0;
+    uint64_t verified = 0;
+    int flit_hops = 0;
+    int tag = 0;
+    if (!multicast_routers.empty()) {
+        int flits = divCeil(msg_bytes +
+            getNumberOfTagBytes(multicast_routers.size()),
+            oPort->bitWidth());
+        int max_hops = 0;
+        for (int router : multicast_routers) {
+            max_hops = std::max(max_hops,
+                m_net_ptr->getRouterDistance(src, router));
         }
+        sent = std::max(sent, (uint64_t)ready[tag++]) + flits;
+        verified = sent + max_hops + m_multicast_verify_cycles;
+        flit_hops += flits *
+            m_net_ptr->getMulticastTreeHops(src, multicast_routers);
     }
-    return true ;
+
+    int unicast_flits =
+        divCeil(msg_bytes + getNumberOfTagBytes(1), oPort->bitWidth());
+    for (int router : unicast_routers) {
+        int hops = m_net_ptr->getRouterDistance(src, router);
+        sent = std::max(sent, (uint64_t)ready[tag++]) + unicast_flits;
+        verified = std::max(verified, sent + hops + siphash_cycles);
+        flit_hops += unicast_flits * hops;
+    }
+
+    return verified + load * flit_hops;
+}
+
+int
+NetworkInterface::getNextPacketID()
+{
+    return m_num_packets++ * m_net_ptr->getNumNodes() + m_id;
 }
 
 // Looking for a free output vc
@@ -656,7 +969,7 @@ NetworkInterface::calculateVC(int vnet)
     return -1;
 }
 
-void
+bool
 NetworkInterface::scheduleOutputPort(OutputPort *oPort)
 {
    int vc = oPort->vcRoundRobin();
@@ -702,6 +1015,7 @@ NetworkInterface::scheduleOutputPort(OutputPort *oPort)
 
                // Scheduling the flit
                scheduleFlit(t_flit);
+               traceFlit(TRACE_INJECT_, t_flit);
 
                if (t_flit->get_type() == TAIL_ ||
                   t_flit->get_type() == HEAD_TAIL_) {
@@ -710,10 +1024,11 @@ NetworkInterface::scheduleOutputPort(OutputPort *oPort)
 
                // Done with this port, continue to schedule
                // other ports
-               return;
+               return true;
            }
        }
    }
+   return false;
 }
 
 
@@ -724,13 +1039,15 @@ NetworkInterface::scheduleOutputPort(OutputPort *oPort)
  *  left, the link is scheduled for the next cycle
  */
 
-void
+bool
 NetworkInterface::scheduleOutputLink()
 {
     // Schedule each output link
+    bool scheduled = false;
     for (auto &oPort: outPorts) {
-        scheduleOutputPort(oPort);
+        scheduled |= scheduleOutputPort(oPort);
     }
+    return scheduled;
 }
 
 NetworkInterface::InputPort *
@@ -769,9 +1086,14 @@ NetworkInterface::scheduleFlit(flit *t_flit)
     OutputPort *oPort = getOutportForVnet(t_flit->get_vnet());
 
     if (oPort) {
-        DPRINTF(RubyNetwork, "Scheduling at %s time:%ld flit:%s Message:%s\n",
-        oPort->outNetLink()->name(), clockEdge(Cycles(1)),
-        *t_flit, *(t_flit->get_msg_ptr()));
+        if (t_flit->is_ghost()) {
+            DPRINTF(RubyNetwork, "Scheduling at %s time:%ld ghost flit:%s\n",
+            oPort->outNetLink()->name(), clockEdge(Cycles(1)), *t_flit);
+        } else {
+            DPRINTF(RubyNetwork, "Scheduling at %s time:%ld flit:%s "
+            "Message:%s\n", oPort->outNetLink()->name(),
+            clockEdge(Cycles(1)), *t_flit, *(t_flit->get_msg_ptr()));
+        }
         oPort->outFlitQueue()->insert(t_flit);
         oPort->outNetLink()->scheduleEventAbsolute(clockEdge(Cycles(1)));
         return;
@@ -794,13 +1116,15 @@ NetworkInterface::get_vnet(int vc)
 
 
 // Wakeup the NI in the next cycle if there are waiting
-// messages in the protocol buffer, or waiting flits in the
-// output VC buffer.
+// messages in the protocol buffer, or at the first cycle a flit
+// in the output VC buffers can be sent.
 // Also check if we have to reschedule because of a clock period
 // difference.
 void
 NetworkInterface::checkReschedule()
 {
+    Tick nextCycle = clockEdge(Cycles(1));
+
     for (const auto& it : inNode_ptr) {
         if (it == nullptr) {
             continue;
@@ -812,13 +1136,25 @@ NetworkInterface::checkReschedule()
         }
     }
 
-    for (int i = 1; i < 100; i++){
-        for (auto& ni_out_vc : niOutVcs) {
-            if (ni_out_vc.isReady(clockEdge(Cycles(i)))) {
-                scheduleEvent(Cycles(i));
-                return;
-            }
+    // A flit waiting for its tag or for the NI pipeline is sent at the
+    // cycle it becomes ready, without waking up in between. A ready flit
+    // that has no credit waits for the credit, which wakes up the NI.
+    Tick next_ready = MaxTick;
+    for (int vc = 0; vc < niOutVcs.size(); vc++) {
+        if (niOutVcs[vc].isEmpty())
+            continue;
+
+        Tick ready = niOutVcs[vc].peekTopFlit()->get_time();
+        if (ready <= curTick()) {
+            if (!outVcState[vc].has_credit())
+                continue;
+            ready = nextCycle;
         }
+        next_ready = std::min(next_ready, std::max(ready, nextCycle));
+    }
+
+    if (next_ready != MaxTick) {
+        scheduleEventAbsolute(next_ready);
     }
 
     // Check if any input links have flits to be popped.
@@ -847,6 +1183,14 @@ NetworkInterface::print(std::ostream& out) const
     out << "[Network Interface]";
 }
 
+void
+NetworkInterface::resetStats()
+{
+    ClockedObject::resetStats();
+    m_num_useful_wakeups = 0;
+    m_num_empty_wakeups = 0;
+}
+
 bool
 NetworkInterface::functionalRead(Packet *pkt, WriteMask &mask)
 {
@@ -878,6 +1222,89 @@ NetworkInterface::functionalWrite(Packet *pkt)
     return num_functional_writes;
 }
 
+// The messages in the protocol buffers, including one that is being
+// sent as unicast packets, belong to the protocol and are not saved
+void
+NetworkInterface::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_SCALAR(m_num_packets);
+    SERIALIZE_CONTAINER(m_vc_allocator);
+    SERIALIZE_CONTAINER(vc_busy_counter);
+    SERIALIZE_CONTAINER(m_last_mac_ready);
+    SERIALIZE_CONTAINER(m_ni_out_vcs_enqueue_time);
+    m_mac_engine.serializeSection(cp, "mac_engine");
+
+    for (int vc = 0; vc < (int)niOutVcs.size(); vc++) {
+        outVcState[vc].serializeSection(cp, csprintf("out_vc%d", vc));
+        serializeFlits(cp, csprintf("vc%d", vc), niOutVcs[vc].getFlits());
+    }
+    for (int i = 0; i < (int)outPorts.size(); i++) {
+        ScopedCheckpointSection sec(cp, csprintf("outport%d", i));
+        int vc_round_robin = outPorts[i]->vcRoundRobin();
+        SERIALIZE_SCALAR(vc_round_robin);
+        serializeFlits(cp, "flits", outPorts[i]->outFlitQueue()->getFlits());
+    }
+    for (int i = 0; i < (int)inPorts.size(); i++) {
+        ScopedCheckpointSection sec(cp, csprintf("inport%d", i));
+        InputPort *iPort = inPorts[i];
+        serializeFlits(cp, "credits", iPort->outCreditQueue()->getFlits());
+        serializeFlits(cp, "stalled", std::vector<flit *>(
+            iPort->m_stall_queue.begin(), iPort->m_stall_queue.end()));
+    }
+}
+
+void
+NetworkInterface::restoreState(CheckpointIn &cp)
+{
+    UNSERIALIZE_SCALAR(m_num_packets);
+    UNSERIALIZE_CONTAINER(m_vc_allocator);
+    UNSERIALIZE_CONTAINER(vc_busy_counter);
+    UNSERIALIZE_CONTAINER(m_last_mac_ready);
+    UNSERIALIZE_CONTAINER(m_ni_out_vcs_enqueue_time);
+    m_mac_engine.unserializeSection(cp, "mac_engine");
+
+    FlitPool *pool = m_net_ptr->getFlitPool(m_partition);
+    for (int vc = 0; vc < (int)niOutVcs.size(); vc++) {
+        outVcState[vc].unserializeSection(cp, csprintf("out_vc%d", vc));
+        for (const auto &state : unserializeFlits(cp, csprintf("vc%d", vc)))
+            niOutVcs[vc].insert(m_net_ptr->restoreFlit(state, pool));
+    }
+    for (int i = 0; i < (int)outPorts.size(); i++) {
+        ScopedCheckpointSection sec(cp, csprintf("outport%d", i));
+        OutputPort *oPort = outPorts[i];
+        int vc_round_robin;
+        UNSERIALIZE_SCALAR(vc_round_robin);
+        oPort->vcRoundRobin(vc_round_robin);
+
+        flitBuffer *queue = oPort->outFlitQueue();
+        for (const auto &state : unserializeFlits(cp, "flits"))
+            queue->insert(m_net_ptr->restoreFlit(state, pool));
+        if (!queue->isEmpty()) {
+            oPort->outNetLink()->scheduleEventAbsolute(
+                std::max(queue->peekTopFlit()->get_time(), curTick()));
+        }
+    }
+    for (int i = 0; i < (int)inPorts.size(); i++) {
+        ScopedCheckpointSection sec(cp, csprintf("inport%d", i));
+        InputPort *iPort = inPorts[i];
+        for (const auto &state : unserializeFlits(cp, "credits"))
+            iPort->sendCredit(
+                (Credit *)m_net_ptr->restoreFlit(state, nullptr));
+
+        // The messages of the stalled packets are not restored, so
+        // their VCs are freed right away
+        for (const auto &state : unserializeFlits(cp, "stalled")) {
+            iPort->sendCredit(new Credit(state.vc, true, curTick()));
+            m_net_ptr->increment_ghost_packets(state.vnet);
+        }
+
+        if (iPort->outCreditQueue()->getSize() > 0)
+            iPort->outCreditLink()->scheduleEventAbsolute(curTick());
+    }
+
+    scheduleEventAbsolute(curTick());
+}
+
 } // namespace garnet
 } // namespace ruby
 } // namespace gem5
@@ -41,6 +41,7 @@
 #include "mem/ruby/network/garnet/Credit.hh"
 #include "mem/ruby/network/garnet/CreditLink.hh"
 #include "mem/ruby/network/garnet/GarnetNetwork.hh"
+#include "mem/ruby/network/garnet/MacEngine.hh"
 #include "mem/ruby/network/garnet/NetworkLink.hh"
 #include "mem/ruby/network/garnet/OutVcState.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
@@ -78,12 +79,22 @@ class NetworkInterface : public ClockedObject, public Consumer
     void print(std::ostream& out) const;
     int get_vnet(int vc);
     void init_net_ptr(GarnetNetwork *net_ptr) { m_net_ptr = net_ptr; }
+    void init_global_id(NodeID global_id);
 
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *);
 
+    void serialize(CheckpointOut &cp) const override;
+    // Called by the network at startup, see GarnetNetwork::restoreState
+    void restoreState(CheckpointIn &cp);
+
     void scheduleFlit(flit *t_flit);
 
+    // Wakeups that did or did not move a message, a flit or a credit
+    double get_useful_wakeups() { return m_num_useful_wakeups; }
+    double get_empty_wakeups() { return m_num_empty_wakeups; }
+    void resetStats() override;
+
     int get_router_id(int vnet)
     {
         OutputPort *oPort = getOutportForVnet(vnet);
@@ -91,9 +102,6 @@ class NetworkInterface : public ClockedObject, public Consumer
         return oPort->routerID();
     }
 
-    Tick get_auth_delay() { return auth_delay; }
-    void set_auth_delay(Tick delay) { auth_delay = delay; }
-
     class OutputPort
     {
       public:
@@ -274,6 +282,7 @@ class NetworkInterface : public ClockedObject, public Consumer
   private:
     GarnetNetwork *m_net_ptr;
     const NodeID m_id;
+    const int m_partition;
     const int m_virtual_networks;
     int m_vc_per_vnet;
     std::vector<int> m_vc_allocator;
@@ -282,10 +291,44 @@ class NetworkInterface : public ClockedObject, public Consumer
     int m_deadlock_threshold;
     int m_multicast_mac_cycles;
     int m_multicast_verify_cycles;
+    int m_siphash_cycles;
+    double m_siphash_cycles_per_byte;
+    int m_siphash_tag_bytes;
+    bool m_auth_tags_in_flits;
+    std::vector<uint32_t> m_multiauth_max_dests;
+    std::vector<uint32_t> m_multiauth_tag_bytes;
+    // Choose the multicast path of each message, see chooseMulticastPath
+    bool m_hybrid_multicast;
+    int m_straggler_hops;
+    double m_hybrid_load_weight;
+    // Computes the tags of the injected messages
+    MacEngine m_mac_engine;
+    // Time the last tag of each vnet is ready
+    std::vector<Tick> m_last_mac_ready;
     std::vector<OutVcState> outVcState;
 
     std::vector<int> m_stall_count;
 
+    double m_num_useful_wakeups = 0;
+    double m_num_empty_wakeups = 0;
+
+    // Packets injected so far. Packet ids are unique per NI so that they
+    // do not depend on the order in which the partitions inject.
+    int m_num_packets = 0;
+    int getNextPacketID();
+
+    // The message of each vnet that is being sent as several packets,
+    // until all of them have been flitisized: its delivery, and the
+    // destinations that have no packet yet. The message itself is
+    // shared with the packets already in flight, which destination NIs
+    // of other partitions read, so it is not modified.
+    struct PendingDelivery
+    {
+        std::shared_ptr<DeliveryInfo> delivery;
+        std::vector<NodeID> dests;
+    };
+    std::vector<PendingDelivery> m_deliveries;
+
     // Input Flit Buffers
     // The flit buffers which will serve the Consumer
     std::vector<flitBuffer>  niOutVcs;
@@ -297,23 +340,50 @@ class NetworkInterface : public ClockedObject, public Consumer
     std::vector<MessageBuffer *> outNode_ptr;
     // When a vc stays busy for a long time, it indicates a deadlock
     std::vector<int> vc_busy_counter;
-    Tick auth_delay;
+    // NetDest that addresses only this NI
+    NetDest m_personal_dest;
 
-    void checkStallQueue();
+    bool checkStallQueue();
     bool flitisizeMessage(MsgPtr msg_ptr, int vnet);
+    bool flitisizeMulticast(MsgPtr msg_ptr, int vnet,
+                            const std::vector<NodeID> &dest_nodes,
+                            const NetDest &dest,
+                            std::shared_ptr<DeliveryInfo> delivery);
+    MulticastPath chooseMulticastPath(int vnet, int msg_bytes,
+                                      std::vector<NodeID> &dest_nodes,
+                                      std::vector<NodeID> &stragglers);
+    double estimatePathCost(int vnet, int msg_bytes,
+                            const std::vector<int> &multicast_routers,
+                            const std::vector<int> &unicast_routers);
     int calculateVC(int vnet);
 
 
-    void scheduleOutputPort(OutputPort *oPort);
-    void scheduleOutputLink();
+    bool scheduleOutputPort(OutputPort *oPort);
+    bool scheduleOutputLink();
     void checkReschedule();
 
     void incrementStats(flit *t_flit);
+    MsgPtr ejectMessage(flit *t_flit);
+
+    void
+    traceFlit(FlitTraceEvent event, flit *t_flit, Tick tick = curTick())
+    {
+        if (FlitTracer *tracer = m_net_ptr->getFlitTracer()) {
+            tracer->record(m_partition, event, t_flit, m_id, -1, -1,
+                           t_flit->get_vc(), tick);
+        }
+    }
 
-    int getNumberOfMultiAuthBytes(int t, int N);
+    static NetDest nodeToNetDest(NodeID node);
+
+    int getNumberOfMultiAuthBytes(int N);
 
     int getNumberOfSpiphshCycles(int msgLength);
 
+    int getNumberOfTagBytes(int num_dests);
+
+    Tick reserveMac(int vnet, Cycles cycles);
+
     InputPort *getInportForVnet(int vnet);
     OutputPort *getOutportForVnet(int vnet);
 };
@@ -32,9 +32,13 @@
 
 #include "mem/ruby/network/garnet/NetworkLink.hh"
 
+#include <algorithm>
+
 #include "base/trace.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/CreditLink.hh"
+#include "mem/ruby/network/garnet/FlitPool.hh"
+#include "mem/ruby/network/garnet/GarnetNetwork.hh"
 
 namespace gem5
 {
@@ -49,7 +53,8 @@ NetworkLink::NetworkLink(const Params &p)
     : ClockedObject(p), Consumer(this), m_id(p.link_id),
       m_type(NUM_LINK_TYPES_),
       m_latency(p.link_latency), m_link_utilized(0),
-      m_virt_nets(p.virt_nets), linkBuffer(),
+      m_consumer_pool(nullptr), m_virt_nets(p.virt_nets),
+      linkBuffer((int)p.link_latency + 1),
       link_consumer(nullptr), link_srcQueue(nullptr)
 {
     int num_vnets = (p.supported_vnets).size();
@@ -98,17 +103,51 @@ NetworkLink::wakeup()
                 (mVnets.size() == 0));
         }
         t_flit->set_time(clockEdge(m_latency));
-        linkBuffer.insert(t_flit);
-        link_consumer->scheduleEventAbsolute(clockEdge(m_latency));
+        if (m_consumer_pool) {
+            m_mailbox.push_back(t_flit);
+        } else {
+            linkBuffer.insert(t_flit);
+            link_consumer->scheduleEventAbsolute(clockEdge(m_latency));
+        }
         m_link_utilized++;
         m_vc_load[t_flit->get_vc()]++;
     }
 
+    // The flits travel on the link as timed arrivals at the consumer.
+    // The link only wakes up again when its next flit can leave.
     if (!link_srcQueue->isEmpty()) {
-        scheduleEvent(Cycles(1));
+        scheduleEventAbsolute(std::max(clockEdge(Cycles(1)),
+            link_srcQueue->peekTopFlit()->get_time()));
     }
 }
 
+void
+NetworkLink::setCrossPartition(FlitPool *consumer_pool)
+{
+    m_consumer_pool = consumer_pool;
+}
+
+void
+NetworkLink::exchangeFlits()
+{
+    assert(m_inbox.empty());
+    m_inbox.swap(m_mailbox);
+}
+
+void
+NetworkLink::deliverFlits()
+{
+    for (flit *t_flit : m_inbox) {
+        DPRINTF(RubyNetwork, "Delivering flit from %s at %ld: %s\n",
+                src_object->name(), t_flit->get_time(), *t_flit);
+        // The flit is released by the consumer's partition from now on
+        m_consumer_pool->adopt(t_flit);
+        linkBuffer.insert(t_flit);
+        link_consumer->scheduleEventAbsolute(t_flit->get_time());
+    }
+    m_inbox.clear();
+}
+
 void
 NetworkLink::resetStats()
 {
@@ -119,16 +158,53 @@ NetworkLink::resetStats()
     m_link_utilized = 0;
 }
 
+void
+NetworkLink::serialize(CheckpointOut &cp) const
+{
+    serializeFlits(cp, "flits", linkBuffer.getFlits());
+    serializeFlits(cp, "inbox", m_inbox);
+    serializeFlits(cp, "mailbox", m_mailbox);
+}
+
+void
+NetworkLink::restoreState(CheckpointIn &cp, GarnetNetwork *net)
+{
+    // The flits that were on their way to another partition are handed
+    // over to the consumer right away
+    FlitPool *pool = m_consumer_pool;
+    if (!pool)
+        pool = net->getFlitPool(params().eventq_index);
+
+    for (const char *section : {"flits", "inbox", "mailbox"}) {
+        for (const auto &state : unserializeFlits(cp, section)) {
+            flit *t_flit = net->restoreFlit(state, pool);
+            linkBuffer.insert(t_flit);
+            link_consumer->scheduleEventAbsolute(
+                std::max(t_flit->get_time(), curTick()));
+        }
+    }
+}
+
 bool
 NetworkLink::functionalRead(Packet *pkt, WriteMask &mask)
 {
-    return linkBuffer.functionalRead(pkt, mask);
+    bool read = linkBuffer.functionalRead(pkt, mask);
+    for (flit *t_flit : m_mailbox)
+        read |= t_flit->functionalRead(pkt, mask);
+    for (flit *t_flit : m_inbox)
+        read |= t_flit->functionalRead(pkt, mask);
+    return read;
 }
 
 uint32_t
 NetworkLink::functionalWrite(Packet *pkt)
 {
-    return linkBuffer.functionalWrite(pkt);
+    uint32_t num_functional_writes = linkBuffer.functionalWrite(pkt);
+    for (flit *t_flit : m_mailbox)
+        num_functional_writes += t_flit->functionalWrite(pkt);
+    for (flit *t_flit : m_inbox)
+        num_functional_writes += t_flit->functionalWrite(pkt);
+    return num_functional_writes;
 }
 
 } // namespace garnet
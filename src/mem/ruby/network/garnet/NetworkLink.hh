@@ -51,6 +51,7 @@ namespace ruby
 namespace garnet
 {
 
+class FlitPool;
 class GarnetNetwork;
 
 class NetworkLink : public ClockedObject, public Consumer
@@ -68,6 +69,8 @@ class NetworkLink : public ClockedObject, public Consumer
     void print(std::ostream& out) const {}
     int get_id() const { return m_id; }
     flitBuffer *getBuffer() { return &linkBuffer;}
+    Consumer *getLinkConsumer() { return link_consumer; }
+    ClockedObject *getSrcObject() { return src_object; }
     virtual void wakeup();
 
     unsigned int getLinkUtilization() const { return m_link_utilized; }
@@ -85,6 +88,22 @@ class NetworkLink : public ClockedObject, public Consumer
     uint32_t functionalWrite(Packet *);
     void resetStats();
 
+    void serialize(CheckpointOut &cp) const override;
+    // Called by the network at startup, see GarnetNetwork::restoreState
+    virtual void restoreState(CheckpointIn &cp, GarnetNetwork *net);
+
+    // A link whose consumer runs on another event queue does not touch
+    // the link buffer when it sends a flit. The flits wait in a mailbox
+    // until the network exchanges them at a quantum boundary, and are
+    // then delivered by the consumer's event queue.
+    void setCrossPartition(FlitPool *consumer_pool);
+    bool isCrossPartition() const { return m_consumer_pool != nullptr; }
+    Tick getLatencyTicks() const { return cyclesToTicks(m_latency); }
+    // Called while all the event queues wait at the quantum barrier
+    void exchangeFlits();
+    // Called from the event queue of the consumer after an exchange
+    void deliverFlits();
+
     std::vector<int> mVnets;
     uint32_t bitWidth;
 
@@ -99,6 +118,13 @@ class NetworkLink : public ClockedObject, public Consumer
     unsigned int m_link_utilized;
     std::vector<unsigned int> m_vc_load;
 
+    // Cross-partition links only: pool of the consumer's partition,
+    // flits sent during the current quantum, and flits exchanged at the
+    // last quantum boundary that have not been delivered yet
+    FlitPool *m_consumer_pool;
+    std::vector<flit *> m_mailbox;
+    std::vector<flit *> m_inbox;
+
   protected:
     uint32_t m_virt_nets;
     flitBuffer linkBuffer;
@@ -77,6 +77,25 @@ OutVcState::decrement_credit()
     assert(m_credit_count >= 0);
 }
 
+void
+OutVcState::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_ENUM(m_vc_state);
+    SERIALIZE_SCALAR(m_time);
+    SERIALIZE_SCALAR(m_credit_count);
+}
+
+void
+OutVcState::unserialize(CheckpointIn &cp)
+{
+    UNSERIALIZE_ENUM(m_vc_state);
+    UNSERIALIZE_SCALAR(m_time);
+    UNSERIALIZE_SCALAR(m_credit_count);
+    fatal_if(m_credit_count < 0 || m_credit_count > m_max_credit_count,
+             "The checkpoint has %d credits for a VC of %d buffers.",
+             m_credit_count, m_max_credit_count);
+}
+
 } // namespace garnet
 } // namespace ruby
 } // namespace gem5
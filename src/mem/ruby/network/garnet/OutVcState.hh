@@ -33,6 +33,7 @@
 
 #include "mem/ruby/network/garnet/CommonTypes.hh"
 #include "mem/ruby/network/garnet/GarnetNetwork.hh"
+#include "sim/serialize.hh"
 
 namespace gem5
 {
@@ -43,7 +44,7 @@ namespace ruby
 namespace garnet
 {
 
-class OutVcState
+class OutVcState : public Serializable
 {
   public:
     OutVcState(int id, GarnetNetwork *network_ptr, uint32_t consumerVcs);
@@ -65,6 +66,9 @@ class OutVcState
         m_time = time;
     }
 
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
   private:
     int m_id ;
     Tick m_time;
@@ -31,6 +31,9 @@
 
 #include "mem/ruby/network/garnet/OutputUnit.hh"
 
+#include <algorithm>
+
+#include "base/cprintf.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/Credit.hh"
 #include "mem/ruby/network/garnet/CreditLink.hh"
@@ -93,12 +96,26 @@ OutputUnit::has_credit(int out_vc)
 }
 
 
+// The escape VC is the first VC of each vnet
+void
+OutputUnit::vc_range(int vnet, VC_class_type vc_class, int &vc_begin,
+                     int &vc_end) const
+{
+    vc_begin = vnet*m_vc_per_vnet;
+    vc_end = vc_begin + m_vc_per_vnet;
+    if (vc_class == ESCAPE_VC_)
+        vc_end = vc_begin + 1;
+    else if (vc_class == ADAPTIVE_VC_)
+        vc_begin++;
+}
+
 // Check if the output port (i.e., input port at next router) has free VCs.
 bool
-OutputUnit::has_free_vc(int vnet)
+OutputUnit::has_free_vc(int vnet, VC_class_type vc_class)
 {
-    int vc_base = vnet*m_vc_per_vnet;
-    for (int vc = vc_base; vc < vc_base + m_vc_per_vnet; vc++) {
+    int vc_begin, vc_end;
+    vc_range(vnet, vc_class, vc_begin, vc_end);
+    for (int vc = vc_begin; vc < vc_end; vc++) {
         if (is_vc_idle(vc, curTick()))
             return true;
     }
@@ -108,10 +125,11 @@ OutputUnit::has_free_vc(int vnet)
 
 // Assign a free output VC to the winner of Switch Allocation
 int
-OutputUnit::select_free_vc(int vnet)
+OutputUnit::select_free_vc(int vnet, VC_class_type vc_class)
 {
-    int vc_base = vnet*m_vc_per_vnet;
-    for (int vc = vc_base; vc < vc_base + m_vc_per_vnet; vc++) {
+    int vc_begin, vc_end;
+    vc_range(vnet, vc_class, vc_begin, vc_end);
+    for (int vc = vc_begin; vc < vc_end; vc++) {
         if (is_vc_idle(vc, curTick())) {
             outVcState[vc].setState(ACTIVE_, curTick());
             return vc;
@@ -121,6 +139,30 @@ OutputUnit::select_free_vc(int vnet)
     return -1;
 }
 
+int
+OutputUnit::get_free_vc_count(int vnet, VC_class_type vc_class)
+{
+    int vc_begin, vc_end;
+    vc_range(vnet, vc_class, vc_begin, vc_end);
+    int count = 0;
+    for (int vc = vc_begin; vc < vc_end; vc++) {
+        if (is_vc_idle(vc, curTick()))
+            count++;
+    }
+    return count;
+}
+
+int
+OutputUnit::get_vnet_credit_count(int vnet, VC_class_type vc_class)
+{
+    int vc_begin, vc_end;
+    vc_range(vnet, vc_class, vc_begin, vc_end);
+    int count = 0;
+    for (int vc = vc_begin; vc < vc_end; vc++)
+        count += outVcState[vc].get_credit_count();
+    return count;
+}
+
 /*
  * The wakeup function of the OutputUnit reads the credit signal from the
  * downstream router for the output VC (i.e., input VC at downstream router).
@@ -147,6 +189,12 @@ OutputUnit::wakeup()
     }
 }
 
+bool
+OutputUnit::has_incoming_credit()
+{
+    return m_credit_link->isReady(curTick());
+}
+
 flitBuffer*
 OutputUnit::getOutQueue()
 {
@@ -184,6 +232,29 @@ OutputUnit::functionalWrite(Packet *pkt)
     return outBuffer.functionalWrite(pkt);
 }
 
+void
+OutputUnit::serialize(CheckpointOut &cp) const
+{
+    for (int vc = 0; vc < (int)outVcState.size(); vc++)
+        outVcState[vc].serializeSection(cp, csprintf("out_vc%d", vc));
+    serializeFlits(cp, "flits", outBuffer.getFlits());
+}
+
+void
+OutputUnit::restoreState(CheckpointIn &cp)
+{
+    for (int vc = 0; vc < (int)outVcState.size(); vc++)
+        outVcState[vc].unserializeSection(cp, csprintf("out_vc%d", vc));
+
+    GarnetNetwork *net = m_router->get_net_ptr();
+    for (const auto &state : unserializeFlits(cp, "flits"))
+        outBuffer.insert(net->restoreFlit(state, m_router->getFlitPool()));
+    if (!outBuffer.isEmpty()) {
+        m_out_link->scheduleEventAbsolute(
+            std::max(outBuffer.peekTopFlit()->get_time(), curTick()));
+    }
+}
+
 } // namespace garnet
 } // namespace ruby
 } // namespace gem5
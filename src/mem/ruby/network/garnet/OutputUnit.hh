@@ -67,8 +67,14 @@ class OutputUnit : public Consumer
     void decrement_credit(int out_vc);
     void increment_credit(int out_vc);
     bool has_credit(int out_vc);
-    bool has_free_vc(int vnet);
-    int select_free_vc(int vnet);
+    bool has_free_vc(int vnet, VC_class_type vc_class = ANY_VC_);
+    int select_free_vc(int vnet, VC_class_type vc_class = ANY_VC_);
+
+    // Downstream buffer state of a class of VCs, used by adaptive
+    // routing to pick the least congested outport
+    int get_free_vc_count(int vnet, VC_class_type vc_class);
+    int get_vnet_credit_count(int vnet, VC_class_type vc_class);
+    bool has_incoming_credit();
 
     inline PortDirection get_direction() { return m_direction; }
 
@@ -107,7 +113,13 @@ class OutputUnit : public Consumer
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *pkt);
 
+    void serialize(CheckpointOut &cp) const;
+    void restoreState(CheckpointIn &cp);
+
   private:
+    void vc_range(int vnet, VC_class_type vc_class, int &vc_begin,
+                  int &vc_end) const;
+
     Router *m_router;
     GEM5_CLASS_VAR_USED int m_id;
     PortDirection m_direction;
@@ -32,6 +32,7 @@
 
 #include "mem/ruby/network/garnet/Router.hh"
 
+#include "base/cprintf.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/CreditLink.hh"
 #include "mem/ruby/network/garnet/GarnetNetwork.hh"
@@ -52,8 +53,9 @@ Router::Router(const Params &p)
   : BasicRouter(p), Consumer(this), m_latency(p.latency),
     m_virtual_networks(p.virt_nets), m_vc_per_vnet(p.vcs_per_vnet),
     m_num_vcs(m_virtual_networks * m_vc_per_vnet), m_bit_width(p.width),
-    m_network_ptr(nullptr), routingUnit(this), switchAllocator(this),
-    crossbarSwitch(this)
+    m_partition(p.eventq_index), m_network_ptr(nullptr),
+    routingUnit(this), switchAllocator(this), crossbarSwitch(this),
+    m_num_useful_wakeups(0), m_num_empty_wakeups(0)
 {
     m_input_unit.clear();
     m_output_unit.clear();
@@ -64,6 +66,9 @@ Router::init()
 {
     BasicRouter::init();
 
+    for (auto &input_unit : m_input_unit) {
+        input_unit->init();
+    }
     switchAllocator.init();
     crossbarSwitch.init();
 }
@@ -74,9 +79,18 @@ Router::wakeup()
     DPRINTF(RubyNetwork, "Router %d woke up\n", m_id);
     assert(clockEdge() == curTick());
 
+    // Only the ports with an incoming flit or credit and the input VCs
+    // holding flits are visited. A wakeup that moves nothing is empty.
+    bool useful = false;
+
     // check for incoming flits
+    int num_flits = 0;
     for (int inport = 0; inport < m_input_unit.size(); inport++) {
-        m_input_unit[inport]->wakeup();
+        if (m_input_unit[inport]->has_incoming_flit()) {
+            m_input_unit[inport]->wakeup();
+            useful = true;
+        }
+        num_flits += m_input_unit[inport]->get_num_flits();
     }
 
     // check for incoming credits
@@ -86,14 +100,29 @@ Router::wakeup()
     // if we want the credit update to take place after SA, this loop should
     // be moved after the SA request
     for (int outport = 0; outport < m_output_unit.size(); outport++) {
-        m_output_unit[outport]->wakeup();
+        if (m_output_unit[outport]->has_incoming_credit()) {
+            m_output_unit[outport]->wakeup();
+            useful = true;
+        }
     }
 
-    // Switch Allocation
-    switchAllocator.wakeup();
+    if (num_flits > 0) {
+        double activity = crossbarSwitch.get_crossbar_activity();
+
+        // Switch Allocation
+        switchAllocator.wakeup();
+
+        // Switch Traversal
+        crossbarSwitch.wakeup();
+
+        if (crossbarSwitch.get_crossbar_activity() != activity)
+            useful = true;
+    }
 
-    // Switch Traversal
-    crossbarSwitch.wakeup();
+    if (useful)
+        m_num_useful_wakeups++;
+    else
+        m_num_empty_wakeups++;
 }
 
 void
@@ -159,9 +188,59 @@ Router::getInportDirection(int inport)
 }
 
 int
-Router::route_compute(RouteInfo route, int inport, PortDirection inport_dirn)
+Router::route_compute(const RouteInfo &route, int inport,
+                      PortDirection inport_dirn, int invc,
+                      VC_class_type &vc_class)
 {
-    return routingUnit.outportCompute(route, inport, inport_dirn);
+    return routingUnit.outportCompute(route, inport, inport_dirn, invc,
+                                      vc_class);
+}
+
+void
+Router::route_compute_multicast(const RouteInfo &route,
+                                const DestMask &dests,
+                                OutInfoTable &out_info)
+{
+    routingUnit.outportComputeMulticast(route, dests, out_info);
+}
+
+/*
+ * A single-flit packet that arrives at an otherwise empty router, and
+ * for which a VC is free at its outport, goes for switch allocation in
+ * the cycle it arrives instead of waiting in the buffer for the rest of
+ * the pipeline. With no other flit buffered in the router, it only
+ * competes for the switch with flits arriving in the same cycle. Its
+ * route is already known, as route computation is done on arrival.
+ */
+bool
+Router::can_bypass(int inport, int invc)
+{
+    if (!m_network_ptr->isBypassEnabled() || m_latency == Cycles(1))
+        return false;
+
+    auto &input_unit = m_input_unit[inport];
+    if (input_unit->peekTopFlit(invc)->get_type() != HEAD_TAIL_)
+        return false;
+
+    const OutInfoTable &out_info = input_unit->get_out_info(invc);
+    if (out_info.outports().size() != 1)
+        return false;
+
+    for (auto &unit : m_input_unit) {
+        if (unit->get_num_flits() != (unit == input_unit ? 1 : 0))
+            return false;
+    }
+
+    int outport = out_info.outports()[0];
+    return m_output_unit[outport]->has_free_vc(invc / m_vc_per_vnet,
+        out_info[outport].vc_class);
+}
+
+void
+Router::initRouting()
+{
+    routingUnit.initMulticastPortMasks();
+    routingUnit.initAdaptiveRouting();
 }
 
 void
@@ -216,6 +295,26 @@ Router::regStats()
         .name(name() + ".sw_output_arbiter_activity")
         .flags(statistics::nozero)
     ;
+
+    m_multicast_replications
+        .name(name() + ".multicast_replications")
+        .flags(statistics::nozero)
+    ;
+
+    m_useful_wakeups
+        .name(name() + ".useful_wakeups")
+        .flags(statistics::nozero)
+    ;
+
+    m_empty_wakeups
+        .name(name() + ".empty_wakeups")
+        .flags(statistics::nozero)
+    ;
+
+    m_bypassed_flits
+        .name(name() + ".bypassed_flits")
+        .flags(statistics::nozero)
+    ;
 }
 
 void
@@ -232,6 +331,32 @@ Router::collateStats()
     m_sw_output_arbiter_activity =
         switchAllocator.get_output_arbiter_activity();
     m_crossbar_activity = crossbarSwitch.get_crossbar_activity();
+    m_multicast_replications =
+        switchAllocator.get_multicast_replications();
+    m_useful_wakeups = m_num_useful_wakeups;
+    m_empty_wakeups = m_num_empty_wakeups;
+
+    m_bypassed_flits = 0;
+    for (int j = 0; j < m_virtual_networks; j++)
+        m_bypassed_flits += get_bypassed_hops(j);
+}
+
+double
+Router::get_buffered_hops(int vnet)
+{
+    double hops = 0;
+    for (auto &input_unit : m_input_unit)
+        hops += input_unit->get_buf_write_activity(vnet);
+    return hops;
+}
+
+double
+Router::get_bypassed_hops(int vnet)
+{
+    double hops = 0;
+    for (auto &input_unit : m_input_unit)
+        hops += input_unit->get_bypass_activity(vnet);
+    return hops;
 }
 
 void
@@ -243,6 +368,8 @@ Router::resetStats()
 
     crossbarSwitch.resetStats();
     switchAllocator.resetStats();
+    m_num_useful_wakeups = 0;
+    m_num_empty_wakeups = 0;
 }
 
 void
@@ -311,6 +438,41 @@ Router::functionalWrite(Packet *pkt)
     return num_functional_writes;
 }
 
+// The crossbar only holds flits during a wakeup of the router, so the
+// buffers of a router are its input VCs and output queues
+void
+Router::serialize(CheckpointOut &cp) const
+{
+    panic_if(crossbarSwitch.get_num_flits() > 0,
+             "%s: cannot checkpoint flits in the crossbar.", name());
+
+    for (int inport = 0; inport < (int)m_input_unit.size(); inport++) {
+        ScopedCheckpointSection sec(cp, csprintf("inport%d", inport));
+        m_input_unit[inport]->serialize(cp);
+    }
+    for (int outport = 0; outport < (int)m_output_unit.size(); outport++) {
+        ScopedCheckpointSection sec(cp, csprintf("outport%d", outport));
+        m_output_unit[outport]->serialize(cp);
+    }
+    ScopedCheckpointSection sec(cp, "switch_allocator");
+    switchAllocator.serialize(cp);
+}
+
+void
+Router::restoreState(CheckpointIn &cp)
+{
+    for (int inport = 0; inport < (int)m_input_unit.size(); inport++) {
+        ScopedCheckpointSection sec(cp, csprintf("inport%d", inport));
+        m_input_unit[inport]->restoreState(cp);
+    }
+    for (int outport = 0; outport < (int)m_output_unit.size(); outport++) {
+        ScopedCheckpointSection sec(cp, csprintf("outport%d", outport));
+        m_output_unit[outport]->restoreState(cp);
+    }
+    ScopedCheckpointSection sec(cp, "switch_allocator");
+    switchAllocator.restoreState(cp);
+}
+
 } // namespace garnet
 } // namespace ruby
 } // namespace gem5
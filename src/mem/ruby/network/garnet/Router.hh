@@ -97,6 +97,23 @@ class Router : public BasicRouter, public Consumer
 
     GarnetNetwork* get_net_ptr()                    { return m_network_ptr; }
 
+    // Flits are allocated from the pool of the router's partition
+    FlitPool *
+    getFlitPool()
+    {
+        return m_network_ptr->getFlitPool(m_partition);
+    }
+
+    void
+    traceFlit(FlitTraceEvent event, flit *t_flit, int inport, int outport,
+              int vc)
+    {
+        if (FlitTracer *tracer = m_network_ptr->getFlitTracer()) {
+            tracer->record(m_partition, event, t_flit, m_id, inport,
+                           outport, vc);
+        }
+    }
+
     InputUnit*
     getInputUnit(unsigned port)
     {
@@ -116,7 +133,14 @@ class Router : public BasicRouter, public Consumer
     PortDirection getOutportDirection(int outport);
     PortDirection getInportDirection(int inport);
 
-    int route_compute(RouteInfo route, int inport, PortDirection direction);
+    int route_compute(const RouteInfo &route, int inport,
+                      PortDirection direction, int invc,
+                      VC_class_type &vc_class);
+    void route_compute_multicast(const RouteInfo &route,
+                                 const DestMask &dests,
+                                 OutInfoTable &out_info);
+    void initRouting();
+    bool can_bypass(int inport, int invc);
     void grant_switch(int inport, flit *t_flit);
     void schedule_wakeup(Cycles time);
 
@@ -126,6 +150,15 @@ class Router : public BasicRouter, public Consumer
 
     void regStats();
     void collateStats();
+    double
+    get_multicast_traversals()
+    {
+        return switchAllocator.get_multicast_traversals();
+    }
+    double get_useful_wakeups() { return m_num_useful_wakeups; }
+    double get_buffered_hops(int vnet);
+    double get_bypassed_hops(int vnet);
+    double get_empty_wakeups() { return m_num_empty_wakeups; }
     void resetStats();
 
     // For Fault Model:
@@ -142,16 +175,24 @@ class Router : public BasicRouter, public Consumer
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *);
 
+    void serialize(CheckpointOut &cp) const override;
+    // Called by the network at startup, see GarnetNetwork::restoreState
+    void restoreState(CheckpointIn &cp);
+
   private:
     Cycles m_latency;
     uint32_t m_virtual_networks, m_vc_per_vnet, m_num_vcs;
     uint32_t m_bit_width;
+    const int m_partition;
     GarnetNetwork *m_network_ptr;
 
     RoutingUnit routingUnit;
     SwitchAllocator switchAllocator;
     CrossbarSwitch crossbarSwitch;
 
+    // Wakeups that did or did not move a flit or a credit
+    double m_num_useful_wakeups, m_num_empty_wakeups;
+
     std::vector<std::shared_ptr<InputUnit>> m_input_unit;
     std::vector<std::shared_ptr<OutputUnit>> m_output_unit;
 
@@ -163,6 +204,15 @@ class Router : public BasicRouter, public Consumer
     statistics::Scalar m_sw_output_arbiter_activity;
 
     statistics::Scalar m_crossbar_activity;
+
+    // Flits created by replicating multicast flits in this router
+    statistics::Scalar m_multicast_replications;
+
+    statistics::Scalar m_useful_wakeups;
+    statistics::Scalar m_empty_wakeups;
+
+    // Flits that skipped the buffering stages of the pipeline
+    statistics::Scalar m_bypassed_flits;
 };
 
 } // namespace garnet
@@ -34,6 +34,7 @@
 #include "base/compiler.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/InputUnit.hh"
+#include "mem/ruby/network/garnet/OutputUnit.hh"
 #include "mem/ruby/network/garnet/Router.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
 
@@ -47,6 +48,7 @@ namespace garnet
 {
 
 RoutingUnit::RoutingUnit(Router *router)
+    : m_rng(router->get_id()), m_adaptive(false)
 {
     m_router = router;
     m_routing_table.clear();
@@ -64,10 +66,46 @@ RoutingUnit::addRoute(std::vector<NetDest>& routing_table_entry)
     }
 }
 
+// Called after addRoute() for the same link
 void
 RoutingUnit::addWeight(int link_weight)
 {
     m_weight_table.push_back(link_weight);
+    compileRoute(m_weight_table.size() - 1);
+}
+
+// Add a link to the candidates of every destination it leads to.
+// Only the links with the minimum weight to a destination are kept.
+void
+RoutingUnit::compileRoute(int link)
+{
+    if (m_dest_candidates.size() < m_routing_table.size()) {
+        m_dest_candidates.resize(m_routing_table.size());
+    }
+
+    int link_weight = m_weight_table[link];
+    for (int vnet = 0; vnet < m_routing_table.size(); vnet++) {
+        assert(m_routing_table[vnet].size() == m_weight_table.size());
+        std::vector<std::vector<int>> &dest_candidates =
+            m_dest_candidates[vnet];
+
+        for (NodeID dest : m_routing_table[vnet][link].getAllDest()) {
+            if (dest >= dest_candidates.size()) {
+                dest_candidates.resize(dest + 1);
+            }
+
+            std::vector<int> &candidates = dest_candidates[dest];
+            if (!candidates.empty() &&
+                link_weight > m_weight_table[candidates[0]]) {
+                continue;
+            }
+            if (!candidates.empty() &&
+                link_weight < m_weight_table[candidates[0]]) {
+                candidates.clear();
+            }
+            candidates.push_back(link);
+        }
+    }
 }
 
 bool
@@ -94,7 +132,7 @@ RoutingUnit::supportsVnet(int vnet, std::vector<int> sVnets)
  * Correct weight assignments are critical to provide deadlock avoidance.
  */
 int
-RoutingUnit::lookupRoutingTable(int vnet, NetDest msg_destination)
+RoutingUnit::lookupRoutingTable(int vnet, const NetDest &msg_destination)
 {
     // First find all possible output link candidates
     // For ordered vnet, just choose the first
@@ -138,12 +176,33 @@ RoutingUnit::lookupRoutingTable(int vnet, NetDest msg_destination)
     // Randomly select any candidate output link
     int candidate = 0;
     if (!(m_router->get_net_ptr())->isVNetOrdered(vnet))
-        candidate = rand() % num_candidates;
+        candidate = m_rng.random<int>(0, num_candidates - 1);
 
     output_link = output_link_candidates.at(candidate);
     return output_link;
 }
 
+// Same as above, for a single destination. The candidates have been
+// compiled when the links were added, so this is a direct lookup.
+int
+RoutingUnit::lookupRoutingTable(int vnet, NodeID dest)
+{
+    const std::vector<std::vector<int>> &dest_candidates =
+        m_dest_candidates[vnet];
+
+    if (dest >= dest_candidates.size() || dest_candidates[dest].empty()) {
+        fatal("Fatal Error:: No Route exists from this Router.");
+    }
+    const std::vector<int> &candidates = dest_candidates[dest];
+
+    // Randomly select any candidate output link
+    int candidate = 0;
+    if (!(m_router->get_net_ptr())->isVNetOrdered(vnet))
+        candidate = m_rng.random<int>(0, candidates.size() - 1);
+
+    return candidates[candidate];
+}
+
 
 void
 RoutingUnit::addInDirection(PortDirection inport_dirn, int inport_idx)
@@ -166,9 +225,12 @@ RoutingUnit::addOutDirection(PortDirection outport_dirn, int outport_idx)
 // table is provided here.
 
 int
-RoutingUnit::outportCompute(RouteInfo route, int inport,
-                            PortDirection inport_dirn)
+RoutingUnit::outportCompute(const RouteInfo &route, int inport,
+                            PortDirection inport_dirn, int invc,
+                            VC_class_type &vc_class)
 {
+    vc_class = ANY_VC_;
+
     int outport = -1;
 
     if (route.dest_router == m_router->get_id()) {
@@ -176,7 +238,7 @@ RoutingUnit::outportCompute(RouteInfo route, int inport,
         // Multiple NIs may be connected to this router,
         // all with output port direction = "Local"
         // Get exact outport id from table
-        outport = lookupRoutingTable(route.vnet, route.net_dest);
+        outport = lookupRoutingTable(route.vnet, route.dest_ni);
         return outport;
     }
 
@@ -187,14 +249,18 @@ RoutingUnit::outportCompute(RouteInfo route, int inport,
 
     switch (routing_algorithm) {
         case TABLE_:  outport =
-            lookupRoutingTable(route.vnet, route.net_dest); break;
+            lookupRoutingTable(route.vnet, route.dest_ni); break;
         case XY_:     outport =
             outportComputeXY(route, inport, inport_dirn); break;
         // any custom algorithm
         case CUSTOM_: outport =
             outportComputeCustom(route, inport, inport_dirn); break;
+        case WEST_FIRST_:
+        case ODD_EVEN_: outport =
+            outportComputeAdaptive(route, inport, inport_dirn, invc,
+                                   vc_class); break;
         default: outport =
-            lookupRoutingTable(route.vnet, route.net_dest); break;
+            lookupRoutingTable(route.vnet, route.dest_ni); break;
     }
 
     assert(outport != -1);
@@ -205,7 +271,7 @@ RoutingUnit::outportCompute(RouteInfo route, int inport,
 // Only for reference purpose in a Mesh
 // By default Garnet uses the routing table
 int
-RoutingUnit::outportComputeXY(RouteInfo route,
+RoutingUnit::outportComputeXY(const RouteInfo &route,
                               int inport,
                               PortDirection inport_dirn)
 {
@@ -260,10 +326,384 @@ RoutingUnit::outportComputeXY(RouteInfo route,
     return m_outports_dirn2idx[outport_dirn];
 }
 
+/*
+ * Minimal adaptive routing on a Mesh. The allowed outports follow the
+ * west-first or the odd-even turn model, so the adaptive VCs alone are
+ * deadlock-free. Among the allowed outports, the one with the most free
+ * VCs and credits downstream is picked.
+ *
+ * The first VC of each vnet is an escape VC. When no adaptive VC is free
+ * on the allowed outports, a packet may move to the escape VC of its XY
+ * outport instead of waiting, and is then routed XY on escape VCs up to
+ * its destination.
+ */
+int
+RoutingUnit::outportComputeAdaptive(const RouteInfo &route,
+                                    int inport,
+                                    PortDirection inport_dirn,
+                                    int invc,
+                                    VC_class_type &vc_class)
+{
+    int vnet = route.vnet;
+
+    // Packets of an ordered vnet must all take the same path
+    if (m_router->get_net_ptr()->isVNetOrdered(vnet))
+        return outportComputeXY(route, inport, inport_dirn);
+
+    // Packets on an escape VC stay on the escape VCs. The VC a packet is
+    // injected into by the NI does not matter.
+    if (inport_dirn != "Local" && invc % m_router->get_vc_per_vnet() == 0) {
+        vc_class = ESCAPE_VC_;
+        return outportComputeXY(route, inport, inport_dirn);
+    }
+
+    int outports[2];
+    int num_outports = adaptiveOutports(route.dest_router,
+                                        inSrcColumn(route.src_router),
+                                        outports);
+    int outport = selectOutport(vnet, outports, num_outports);
+
+    if (m_router->getOutputUnit(outport)->get_free_vc_count(vnet,
+            ADAPTIVE_VC_) == 0) {
+        // The packet may turn anywhere onto the escape VCs
+        int xy_outport = outportComputeXY(route, inport, "Local");
+        if (m_router->getOutputUnit(xy_outport)->has_free_vc(vnet,
+                ESCAPE_VC_)) {
+            DPRINTF(RubyNetwork, "Router %d: escape VC out of outport %d\n",
+                    m_router->get_id(), xy_outport);
+            vc_class = ESCAPE_VC_;
+            return xy_outport;
+        }
+    }
+
+    vc_class = ADAPTIVE_VC_;
+    return outport;
+}
+
+int
+RoutingUnit::adaptiveOutports(int dest_router, bool in_src_column,
+                              int outports[2])
+{
+    GarnetNetwork *net_ptr = m_router->get_net_ptr();
+    int num_cols = net_ptr->getNumCols();
+
+    int my_id = m_router->get_id();
+    int my_x = my_id % num_cols;
+    int my_y = my_id / num_cols;
+
+    int dest_x = dest_router % num_cols;
+    int dest_y = dest_router / num_cols;
+
+    int x_offset = dest_x - my_x;
+    int y_offset = dest_y - my_y;
+    assert(x_offset != 0 || y_offset != 0);
+
+    bool x_allowed = (x_offset != 0);
+    bool y_allowed = (y_offset != 0);
+
+    if (net_ptr->getRoutingAlgorithm() == WEST_FIRST_) {
+        // All the west hops are taken first
+        if (x_offset < 0)
+            y_allowed = false;
+    } else {
+        // Odd-even: no East to North/South turn in an even column, and
+        // no North/South to West turn in an odd column
+        bool odd_column = (my_x % 2 == 1);
+        if (x_offset > 0) {
+            y_allowed = y_allowed && (odd_column || in_src_column);
+            // Going east must not end in an even column that the packet
+            // then cannot turn in
+            x_allowed = !y_allowed || dest_x % 2 == 1 || x_offset > 1;
+        } else if (x_offset < 0) {
+            y_allowed = y_allowed && !odd_column;
+        }
+    }
+
+    int num_outports = 0;
+    if (x_allowed) {
+        outports[num_outports++] =
+            m_outports_dirn2idx.at(x_offset > 0 ? "East" : "West");
+    }
+    if (y_allowed) {
+        outports[num_outports++] =
+            m_outports_dirn2idx.at(y_offset > 0 ? "North" : "South");
+    }
+    assert(num_outports > 0);
+    return num_outports;
+}
+
+bool
+RoutingUnit::inSrcColumn(int src_router)
+{
+    int num_cols = m_router->get_net_ptr()->getNumCols();
+    return (src_router % num_cols) == (m_router->get_id() % num_cols);
+}
+
+// More free VCs first, then more credits
+bool
+RoutingUnit::lessCongested(int vnet, int outport, int other_outport)
+{
+    OutputUnit *output_unit = m_router->getOutputUnit(outport);
+    OutputUnit *other_unit = m_router->getOutputUnit(other_outport);
+
+    int free_vcs = output_unit->get_free_vc_count(vnet, ADAPTIVE_VC_);
+    int other_free_vcs = other_unit->get_free_vc_count(vnet, ADAPTIVE_VC_);
+    if (free_vcs != other_free_vcs)
+        return free_vcs > other_free_vcs;
+
+    return output_unit->get_vnet_credit_count(vnet, ADAPTIVE_VC_) >
+           other_unit->get_vnet_credit_count(vnet, ADAPTIVE_VC_);
+}
+
+int
+RoutingUnit::selectOutport(int vnet, const int outports[], int num_outports)
+{
+    int outport = outports[0];
+    for (int i = 1; i < num_outports; i++) {
+        if (lessCongested(vnet, outports[i], outport))
+            outport = outports[i];
+    }
+    return outport;
+}
+
+// Packets are ejected to NIs on any VC
+VC_class_type
+RoutingUnit::adaptiveVcClass(int outport)
+{
+    return m_outports_idx2dirn.at(outport) == "Local" ? ANY_VC_
+                                                      : ADAPTIVE_VC_;
+}
+
+/*
+ * Multicast packets carry their destinations as a DestMask. Instead of
+ * computing a route per destination at every hop, each router precomputes
+ * the set of destinations it sends out of each outport. The destination
+ * mask is then split into per-outport sub-masks with one AND per outport.
+ *
+ * The port masks follow the unicast routing algorithm so that every
+ * branch of the multicast tree takes the same path a unicast packet to
+ * that destination would. For table-based routing, the first
+ * minimum-weight candidate is used so that all packets to a destination
+ * share the same branch.
+ */
+void
+RoutingUnit::initMulticastPortMasks()
+{
+    GarnetNetwork *net_ptr = m_router->get_net_ptr();
+    int num_nis = net_ptr->getNumNodes();
+    int num_outports = m_weight_table.size();
+    RoutingAlgorithm routing_algorithm =
+        (RoutingAlgorithm) net_ptr->getRoutingAlgorithm();
+
+    m_port_masks.resize(m_routing_table.size());
+    for (int vnet = 0; vnet < m_routing_table.size(); vnet++) {
+        m_port_masks[vnet].assign(num_outports, DestMask());
+
+        // Destinations reachable out of each outport per the routing table
+        std::vector<DestMask> reachable(num_outports);
+        for (int link = 0; link < m_routing_table[vnet].size(); link++) {
+            for (NodeID dest : m_routing_table[vnet][link].getAllDest())
+                reachable[link].add(net_ptr->getLocalNodeID(dest));
+        }
+
+        for (int ni = 0; ni < num_nis; ni++) {
+            int outport = -1;
+            int dest_router = net_ptr->get_local_router_id(ni, vnet);
+
+            if ((routing_algorithm == XY_ ||
+                 routing_algorithm == WEST_FIRST_ ||
+                 routing_algorithm == ODD_EVEN_) &&
+                dest_router != m_router->get_id()) {
+                RouteInfo route;
+                route.vnet = vnet;
+                route.dest_ni = ni;
+                route.dest_router = dest_router;
+                outport = outportComputeXY(route, -1, "Local");
+            } else {
+                int min_weight = INFINITE_;
+                for (int link = 0; link < num_outports; link++) {
+                    if (reachable[link].isElement(ni) &&
+                        m_weight_table[link] < min_weight) {
+                        min_weight = m_weight_table[link];
+                        outport = link;
+                    }
+                }
+            }
+
+            if (outport != -1)
+                m_port_masks[vnet][outport].add(ni);
+        }
+    }
+}
+
+void
+RoutingUnit::outportComputeMulticast(const RouteInfo &route,
+                                     const DestMask &dests,
+                                     OutInfoTable &out_info)
+{
+    int vnet = route.vnet;
+    if (m_adaptive && !m_router->get_net_ptr()->isVNetOrdered(vnet)) {
+        outportComputeMulticastAdaptive(route, dests, out_info);
+        return;
+    }
+
+    const std::vector<DestMask> &port_masks = m_port_masks[vnet];
+    DestMask unrouted = dests;
+
+    for (int outport = 0; outport < port_masks.size(); outport++) {
+        if (dests.intersectionIsEmpty(port_masks[outport]))
+            continue;
+
+        out_info.add(outport, dests.AND(port_masks[outport]));
+        unrouted.removeMask(port_masks[outport]);
+    }
+
+    if (!unrouted.isEmpty()) {
+        fatal("Fatal Error:: No Route exists from this Router.");
+    }
+}
+
+/*
+ * Under adaptive routing, the directions a multicast packet may take to
+ * each destination are precomputed like the port masks, as the
+ * destinations for which each outport is an allowed minimal direction.
+ * A destination that has a single allowed outport is also added to the
+ * forced mask of that outport. The masks are kept both for packets
+ * injected in the column of this router and for the others, as the
+ * odd-even turn model depends on it.
+ */
+void
+RoutingUnit::initAdaptiveRouting()
+{
+    GarnetNetwork *net_ptr = m_router->get_net_ptr();
+    RoutingAlgorithm routing_algorithm =
+        (RoutingAlgorithm) net_ptr->getRoutingAlgorithm();
+    m_adaptive = (routing_algorithm == WEST_FIRST_ ||
+                  routing_algorithm == ODD_EVEN_);
+    if (!m_adaptive)
+        return;
+
+    fatal_if(net_ptr->getNumRows() <= 0,
+             "Adaptive routing is only supported on a Mesh.");
+    fatal_if(m_router->get_vc_per_vnet() < 2,
+             "Adaptive routing needs an escape VC and at least one "
+             "adaptive VC per vnet in router %d.", m_router->get_id());
+
+    int num_nis = net_ptr->getNumNodes();
+    int num_outports = m_weight_table.size();
+    m_branches.assign(num_outports, DestMask());
+
+    for (int src_column = 0; src_column < 2; src_column++) {
+        m_adaptive_masks[src_column].resize(m_port_masks.size());
+        m_forced_masks[src_column].resize(m_port_masks.size());
+
+        for (int vnet = 0; vnet < m_port_masks.size(); vnet++) {
+            std::vector<DestMask> &adaptive_masks =
+                m_adaptive_masks[src_column][vnet];
+            std::vector<DestMask> &forced_masks =
+                m_forced_masks[src_column][vnet];
+            adaptive_masks.assign(num_outports, DestMask());
+            forced_masks.assign(num_outports, DestMask());
+
+            for (int ni = 0; ni < num_nis; ni++) {
+                int dest_router = net_ptr->get_local_router_id(ni, vnet);
+                if (dest_router == m_router->get_id()) {
+                    // Ejection, as for the other algorithms
+                    for (int outport = 0; outport < num_outports;
+                         outport++) {
+                        if (m_port_masks[vnet][outport].isElement(ni)) {
+                            adaptive_masks[outport].add(ni);
+                            forced_masks[outport].add(ni);
+                        }
+                    }
+                    continue;
+                }
+
+                int outports[2];
+                int count = adaptiveOutports(dest_router, src_column,
+                                             outports);
+                for (int i = 0; i < count; i++)
+                    adaptive_masks[outports[i]].add(ni);
+                if (count == 1)
+                    forced_masks[outports[0]].add(ni);
+            }
+        }
+    }
+}
+
+/*
+ * The branches of a multicast packet are chosen to keep the destinations
+ * together as far as possible, so that the packet is replicated late and
+ * traverses fewer links in total. Destinations with a single allowed
+ * direction open the first branches, the other destinations join them
+ * where they can, and the remaining ones are covered greedily by the
+ * outports that serve most of them, the least congested first.
+ */
+void
+RoutingUnit::outportComputeMulticastAdaptive(const RouteInfo &route,
+                                             const DestMask &dests,
+                                             OutInfoTable &out_info)
+{
+    int vnet = route.vnet;
+    bool src_column = inSrcColumn(route.src_router);
+    const std::vector<DestMask> &adaptive_masks =
+        m_adaptive_masks[src_column][vnet];
+    const std::vector<DestMask> &forced_masks =
+        m_forced_masks[src_column][vnet];
+    int num_outports = adaptive_masks.size();
+    DestMask unrouted = dests;
+
+    for (int outport = 0; outport < num_outports; outport++) {
+        if (unrouted.intersectionIsEmpty(forced_masks[outport]))
+            continue;
+        m_branches[outport] = unrouted.AND(forced_masks[outport]);
+        unrouted.removeMask(m_branches[outport]);
+    }
+
+    for (int outport = 0; outport < num_outports; outport++) {
+        if (m_branches[outport].isEmpty() ||
+            unrouted.intersectionIsEmpty(adaptive_masks[outport])) {
+            continue;
+        }
+        DestMask joining = unrouted.AND(adaptive_masks[outport]);
+        m_branches[outport].addMask(joining);
+        unrouted.removeMask(joining);
+    }
+
+    while (!unrouted.isEmpty()) {
+        int best_outport = -1;
+        int best_count = 0;
+        for (int outport = 0; outport < num_outports; outport++) {
+            int count = unrouted.AND(adaptive_masks[outport]).count();
+            if (count > best_count ||
+                (count > 0 && count == best_count &&
+                 lessCongested(vnet, outport, best_outport))) {
+                best_outport = outport;
+                best_count = count;
+            }
+        }
+
+        if (best_outport == -1) {
+            fatal("Fatal Error:: No Route exists from this Router.");
+        }
+        m_branches[best_outport] =
+            unrouted.AND(adaptive_masks[best_outport]);
+        unrouted.removeMask(m_branches[best_outport]);
+    }
+
+    for (int outport = 0; outport < num_outports; outport++) {
+        if (m_branches[outport].isEmpty())
+            continue;
+        out_info.add(outport, m_branches[outport],
+                     adaptiveVcClass(outport));
+        m_branches[outport].clear();
+    }
+}
+
 // Template for implementing custom routing algorithm
 // using port directions. (Example adaptive)
 int
-RoutingUnit::outportComputeCustom(RouteInfo route,
+RoutingUnit::outportComputeCustom(const RouteInfo &route,
                                  int inport,
                                  PortDirection inport_dirn)
 {
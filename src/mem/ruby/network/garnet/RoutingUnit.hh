@@ -31,6 +31,7 @@
 #ifndef __MEM_RUBY_NETWORK_GARNET_0_ROUTINGUNIT_HH__
 #define __MEM_RUBY_NETWORK_GARNET_0_ROUTINGUNIT_HH__
 
+#include "base/random.hh"
 #include "mem/ruby/common/Consumer.hh"
 #include "mem/ruby/common/NetDest.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
@@ -53,31 +54,63 @@ class RoutingUnit
 {
   public:
     RoutingUnit(Router *router);
-    int outportCompute(RouteInfo route,
+    // vc_class is set to the VCs the packet may use at the next router
+    int outportCompute(const RouteInfo &route,
                       int inport,
-                      PortDirection inport_dirn);
+                      PortDirection inport_dirn,
+                      int invc,
+                      VC_class_type &vc_class);
 
     // Topology-agnostic Routing Table based routing (default)
     void addRoute(std::vector<NetDest>& routing_table_entry);
     void addWeight(int link_weight);
 
     // get output port from routing table
-    int  lookupRoutingTable(int vnet, NetDest net_dest);
+    int  lookupRoutingTable(int vnet, const NetDest &net_dest);
+    // get output port from the compiled routing table
+    // for a single (global) destination
+    int  lookupRoutingTable(int vnet, NodeID dest);
 
     // Topology-specific direction based routing
     void addInDirection(PortDirection inport_dirn, int inport);
     void addOutDirection(PortDirection outport_dirn, int outport);
 
     // Routing for Mesh
-    int outportComputeXY(RouteInfo route,
+    int outportComputeXY(const RouteInfo &route,
                          int inport,
                          PortDirection inport_dirn);
 
+    // Minimal adaptive routing for Mesh (west-first or odd-even),
+    // with XY routing on the escape VCs
+    int outportComputeAdaptive(const RouteInfo &route,
+                               int inport,
+                               PortDirection inport_dirn,
+                               int invc,
+                               VC_class_type &vc_class);
+
     // Custom Routing Algorithm using Port Directions
-    int outportComputeCustom(RouteInfo route,
+    int outportComputeCustom(const RouteInfo &route,
                              int inport,
                              PortDirection inport_dirn);
 
+    // Multicast tree routing
+    // The port masks are computed once all the routers and NIs in the
+    // network have been connected.
+    void initMulticastPortMasks();
+
+    // Split the destination mask of a multicast packet into the
+    // sub-masks to be forwarded out of each outport.
+    void outportComputeMulticast(const RouteInfo &route,
+                                 const DestMask &dests,
+                                 OutInfoTable &out_info);
+
+    // Adaptive multicast: the branches are chosen per packet among the
+    // minimal directions to each destination
+    void initAdaptiveRouting();
+    void outportComputeMulticastAdaptive(const RouteInfo &route,
+                                         const DestMask &dests,
+                                         OutInfoTable &out_info);
+
     // Returns true if vnet is present in the vector
     // of vnets or if the vector supports all vnets.
     bool supportsVnet(int vnet, std::vector<int> sVnets);
@@ -86,10 +119,44 @@ class RoutingUnit
   private:
     Router *m_router;
 
+    // Picks among equal candidates. Seeded per router so that the choice
+    // does not depend on how the routers are spread over event queues.
+    Random m_rng;
+
     // Routing Table
     std::vector<std::vector<NetDest>> m_routing_table;
     std::vector<int> m_weight_table;
 
+    // Routing table compiled per destination: the minimum-weight
+    // candidate links, in increasing order, to each (global) destination,
+    // indexed by [vnet][destination]
+    std::vector<std::vector<std::vector<int>>> m_dest_candidates;
+    void compileRoute(int link);
+
+    // Multicast port masks: destination NIs that this router forwards
+    // through each outport, indexed by [vnet][outport]
+    std::vector<std::vector<DestMask>> m_port_masks;
+
+    // Adaptive routing
+    bool m_adaptive;
+    // The minimal outports to dest_router allowed by the turn model.
+    // Odd-even also depends on whether the packet was injected in the
+    // column of this router. Returns the number of outports (1 or 2).
+    int adaptiveOutports(int dest_router, bool in_src_column,
+                         int outports[2]);
+    bool inSrcColumn(int src_router);
+    bool lessCongested(int vnet, int outport, int other_outport);
+    int selectOutport(int vnet, const int outports[], int num_outports);
+    VC_class_type adaptiveVcClass(int outport);
+
+    // Destination NIs for which each outport is an allowed minimal
+    // direction, and those for which it is the only one, indexed by
+    // [in_src_column][vnet][outport]
+    std::vector<std::vector<DestMask>> m_adaptive_masks[2];
+    std::vector<std::vector<DestMask>> m_forced_masks[2];
+    // Branches of the multicast packet being routed, by outport
+    std::vector<DestMask> m_branches;
+
     // Inport and Outport direction to idx maps
     std::map<PortDirection, int> m_inports_dirn2idx;
     std::map<int, PortDirection> m_inports_idx2dirn;
@@ -56,6 +56,8 @@ SwitchAllocator::SwitchAllocator(Router *router)
 
     m_input_arbiter_activity = 0;
     m_output_arbiter_activity = 0;
+    m_multicast_replications = 0;
+    m_multicast_traversals = 0;
 }
 
 void
@@ -70,7 +72,7 @@ SwitchAllocator::init()
 
     for (int i = 0; i < m_num_inports; i++) {
         m_round_robin_invc[i] = 0;
-        m_port_requests[i] = std::vector<OutInfo>();
+        m_port_requests[i].assign(m_num_outports, false);
         m_vc_winners[i] = -1;
     }
 
@@ -114,34 +116,36 @@ SwitchAllocator::arbitrate_inports()
     // Select a VC from each input in a round robin manner
     // Independent arbiter at each input port
     for (int inport = 0; inport < m_num_inports; inport++) {
+        auto input_unit = m_router->getInputUnit(inport);
+        if (input_unit->get_num_flits() == 0)
+            continue;
+
         int invc = m_round_robin_invc[inport];
 
         for (int invc_iter = 0; invc_iter < m_num_vcs; invc_iter++) {
-            auto input_unit = m_router->getInputUnit(inport);
-
             if (input_unit->need_stage(invc, SA_, curTick())) {
                 // This flit is in SA stage
 
-                std::vector<OutInfo> out_info = input_unit->get_out_info(invc);
+                const OutInfoTable &out_info = input_unit->get_out_info(invc);
 
+                // The flit at the head of this VC still has to be sent out
+                // of every outport whose branch covers one of its
+                // remaining destinations.
                 // check if the flit in this InputVC is allowed to be sent
                 // send_allowed conditions described in that function.
-                std::vector<OutInfo> new_out_info(m_router->get_num_outports());
-
                 bool make_request = false;
 
-                for (size_t outport = 0; outport < out_info.size(); ++outport) {
-                    if(out_info[outport].routes.size() !=0 && send_allowed(inport, invc, outport, out_info[outport].outvc)){
-                        new_out_info[outport] = out_info[outport];
-                        // out_info[outport] = new OutInfo();
+                for (int outport : out_info.outports()) {
+                    if (is_branch_pending(inport, invc, outport) &&
+                        send_allowed(inport, invc, outport,
+                                     out_info[outport].outvc)) {
+                        m_port_requests[inport][outport] = true;
                         make_request = true;
                     }
-                }           
+                }
 
                 if (make_request) {
                     m_input_arbiter_activity++;
-                    // TODO: when clearing m_port_request make sure the unused out_info get back to the invc of input_unit
-                    m_port_requests[inport] = new_out_info;
                     m_vc_winners[inport] = invc;
 
                     break; // got one vc winner for this port
@@ -157,17 +161,14 @@ SwitchAllocator::arbitrate_inports()
 
 
 /*
-* Returns true if the out_info contains the given outport and false otherwise.
-*/
+ * Returns true if the VC winner of the inport requested the outport
+ * during SA-I, and false otherwise.
+ */
 
-bool 
-SwitchAllocator::is_outport_requested(std::vector<OutInfo> inport_out_info, int outport)
+bool
+SwitchAllocator::is_outport_requested(int inport, int outport)
 {
-    // first check if input port has any request in this cycle and then check if the outport is requested
-    if (inport_out_info.size() != 0 && inport_out_info[outport].routes.size() != 0) {
-        return true;
-    }
-    return false;
+    return m_port_requests[inport][outport];
 }
 
 
@@ -198,69 +199,71 @@ SwitchAllocator::arbitrate_outports()
                  inport_iter++) {
 
             // inport has a request this cycle for outport
-            if (is_outport_requested(m_port_requests[inport], outport)) {
+            if (is_outport_requested(inport, outport)) {
                 auto output_unit = m_router->getOutputUnit(outport);
                 auto input_unit = m_router->getInputUnit(inport);
 
                 // grant this outport to this inport
                 int invc = m_vc_winners[inport];
 
-                OutInfo out_info = input_unit->get_out_info(invc)[outport];
-                if (out_info.outvc == -1) {
+                const OutInfo &out_info =
+                    input_unit->get_out_info(invc)[outport];
+                int outvc = out_info.outvc;
+                if (outvc == -1) {
                     // VC Allocation - select any free VC from outport
-                    out_info = vc_allocate(out_info, outport, inport, invc);
+                    outvc = vc_allocate(outport, inport, invc);
                 }
 
-// peak top flit and duplicate flit here and transfer the stat information later (only one should carry all the information other should reset)
-// clean out selected outport from m_port_request and original input_request 
-// delete condition for flit : if m_port_request and original input_request does not has routes for all outports
-// stat transfer can be done for the deletion of the flit
-// credit decrement in outpout port for each flit, but increment in input port for only when flit is deleted
-
-                // remove flit from Input VC
+                // A multicast flit is replicated once per branch. The flit
+                // in the input VC keeps the destinations that are still to
+                // be served; the last branch takes the flit itself.
+                // Credits are only returned upstream for the last branch.
                 flit *t_flit_peak = input_unit->peekTopFlit(invc);
                 flit *t_flit = nullptr;
 
-                // check wether the flit is done branching out in this router acording to multicast algorithm
-                bool is_last = false;
-                if (t_flit_peak->get_eff_dest() == out_info.routes.size())
-                {
-                    is_last = true;
+                bool is_last =
+                    t_flit_peak->get_dest_mask().isEqual(out_info.dests);
+                if (is_last) {
+                    // remove flit from Input VC
                     t_flit = input_unit->getTopFlit(invc);
-
-                    t_flit->set_msg_ptrs(out_info.msg_ptrs);
-                    t_flit->set_routes(out_info.routes);
-                    t_flit->set_vc(out_info.outvc);
-
                 } else {
-                    
-                    //update the number of effective destinations in the flit in input buffer
-                    t_flit_peak->set_eff_dest(t_flit_peak->get_eff_dest() - out_info.routes.size());
-
-                    // duplicating flit for branching out
-                    t_flit = new flit(
-                    t_flit_peak->getPacketID(),
-                    t_flit_peak->get_id(),
-                    out_info.outvc,
-                    t_flit_peak->get_vnet(),
-                    out_info.routes,
-                    t_flit_peak->get_size(),
-                    out_info.routes.size(),
-                    out_info.msg_ptrs,
-                    t_flit_peak->msgSize,
-                    t_flit_peak->m_width,
-                    curTick());
-
+                    DestMask remaining = t_flit_peak->get_dest_mask();
+                    remaining.removeMask(out_info.dests);
+                    t_flit_peak->set_dest_mask(remaining);
+
+                    // duplicate the flit for this branch; the packet state
+                    // is shared, not copied
+                    FlitPool *pool = m_router->getFlitPool();
+                    t_flit = pool->create(t_flit_peak->getPacketID(),
+                                          t_flit_peak->get_id(),
+                                          outvc,
+                                          t_flit_peak->get_vnet(),
+                                          t_flit_peak->get_packet(),
+                                          out_info.dests,
+                                          t_flit_peak->get_size(),
+                                          t_flit_peak->msgSize,
+                                          t_flit_peak->m_width,
+                                          curTick());
+
+                    // every destination accounts for the full latency of
+                    // the packet
+                    t_flit->set_enqueue_time(t_flit_peak->get_enqueue_time());
+                    t_flit->set_hops_traversed(
+                        t_flit_peak->get_hops_traversed());
                     t_flit->set_is_multiauth(t_flit_peak->is_multiauth());
-                    t_flit->set_src_delay(m_router->cyclesToTicks(Cycles(0)));
+                    t_flit->set_src_delay(t_flit_peak->get_src_delay());
+                    m_multicast_replications++;
+
+                    DPRINTF(GarnetMulticast, "Router %d branched flit %s "
+                            "towards %s\n", m_router->get_id(), *t_flit,
+                            out_info.dests);
                 }
-                
 
                 DPRINTF(RubyNetwork, "SwitchAllocator at Router %d "
                                      "granted outvc %d at outport %d "
                                      "to invc %d at inport %d to flit %s at "
                                      "cycle: %lld\n",
-                        m_router->get_id(), out_info.outvc,
+                        m_router->get_id(), outvc,
                         m_router->getPortDirectionName(
                             output_unit->get_direction()),
                         invc,
@@ -279,17 +282,22 @@ SwitchAllocator::arbitrate_outports()
 
                 // set outvc (i.e., invc for next hop) in flit
                 // (This was updated in VC by vc_allocate, but not in flit)
-                t_flit->set_vc(out_info.outvc);
+                t_flit->set_vc(outvc);
+                m_router->traceFlit(is_last ? TRACE_ROUTER_OUT_
+                                            : TRACE_BRANCH_,
+                                    t_flit, inport, outport, outvc);
 
                 // decrement credit in outvc
-                output_unit->decrement_credit(out_info.outvc);
+                output_unit->decrement_credit(outvc);
 
                 // flit ready for Switch Traversal
                 t_flit->advance_stage(ST_, curTick());
                 m_router->grant_switch(inport, t_flit);
                 m_output_arbiter_activity++;
+                if (t_flit->is_multicast())
+                    m_multicast_traversals++;
 
-                if(is_last){
+                if (is_last) {
                     if ((t_flit->get_type() == TAIL_) ||
                         t_flit->get_type() == HEAD_TAIL_) {
 
@@ -307,14 +315,11 @@ SwitchAllocator::arbitrate_outports()
                         // but do not indicate that the VC is idle
                         input_unit->increment_credit(invc, false, curTick());
                     }
-                } else {
-                    //remove this out information relavent to this outport from the input unit (other out info for other out ports of the input unit still needed to be managed)
-                    // no need to do this if it's the last flit=true since the whole vc is set idle in that case
-                    m_router->getInputUnit(inport)->update_out_info(invc, outport, OutInfo());
                 }
 
-                // remove this outport of this request (other outports of the request still needed to be managed)
-                m_port_requests[inport][outport] = OutInfo();
+                // remove this outport from the request; the other outports
+                // of the request are still to be arbitrated this cycle
+                m_port_requests[inport][outport] = false;
 
                 // Update Round Robin pointer
                 m_round_robin_inport[outport] = inport + 1;
@@ -371,7 +376,10 @@ SwitchAllocator::send_allowed(int inport, int invc, int outport, int outvc)
         // needs outvc
         // this is only true for HEAD and HEAD_TAIL flits.
 
-        if (output_unit->has_free_vc(vnet)) {
+        VC_class_type vc_class =
+            m_router->getInputUnit(inport)->get_out_info(invc)[outport]
+                .vc_class;
+        if (output_unit->has_free_vc(vnet, vc_class)) {
 
             has_outvc = true;
 
@@ -390,26 +398,56 @@ SwitchAllocator::send_allowed(int inport, int invc, int outport, int outvc)
 
     // protocol ordering check
     if ((m_router->get_net_ptr())->isVNetOrdered(vnet)) {
-        panic("Ordred Vnet is not supported with multicast router at the moment");
+        auto input_unit = m_router->getInputUnit(inport);
+
+        // enqueue time of this flit
+        Tick t_enqueue_time = input_unit->get_enqueue_time(invc);
+
+        // check if any other flit is ready for SA and still has a branch
+        // to send out of the same output port, and was enqueued before
+        // this flit. A multicast flit blocks the younger flits of the
+        // outports it has not been sent out of yet, so the packets to
+        // every destination leave in order.
+        int vc_base = vnet*m_vc_per_vnet;
+        for (int vc_offset = 0; vc_offset < m_vc_per_vnet; vc_offset++) {
+            int temp_vc = vc_base + vc_offset;
+            if (input_unit->need_stage(temp_vc, SA_, curTick()) &&
+               is_branch_pending(inport, temp_vc, outport) &&
+               (input_unit->get_enqueue_time(temp_vc) < t_enqueue_time)) {
+                return false;
+            }
+        }
     }
 
     return true;
 }
 
+// Whether the flit at the head of invc still has destinations behind
+// outport, i.e. it has to be sent out of outport
+bool
+SwitchAllocator::is_branch_pending(int inport, int invc, int outport)
+{
+    auto input_unit = m_router->getInputUnit(inport);
+    const OutInfo &out_info = input_unit->get_out_info(invc)[outport];
+    return !out_info.dests.intersectionIsEmpty(
+        input_unit->peekTopFlit(invc)->get_dest_mask());
+}
+
 
 // Assign a free VC to the winner of the output port.
-OutInfo
-SwitchAllocator::vc_allocate(OutInfo outinfo, int outport, int inport, int invc)
+int
+SwitchAllocator::vc_allocate(int outport, int inport, int invc)
 {
-    // Select a free VC from the output port
-    int outvc =
-        m_router->getOutputUnit(outport)->select_free_vc(get_vnet(invc));
+    // Select a free VC of the class allowed by routing from the output port
+    OutInfo &out_info =
+        m_router->getInputUnit(inport)->get_out_info(invc)[outport];
+    int outvc = m_router->getOutputUnit(outport)->select_free_vc(
+        get_vnet(invc), out_info.vc_class);
 
     // has to get a valid VC since it checked before performing SA
     assert(outvc != -1);
-    outinfo.outvc = outvc;
-    m_router->getInputUnit(inport)->update_out_info(invc, outport, outinfo);
-    return outinfo;
+    out_info.outvc = outvc;
+    return outvc;
 }
 
 // Wakeup the router next cycle to perform SA again
@@ -423,9 +461,17 @@ SwitchAllocator::check_for_wakeup()
         return;
     }
 
+    // A flit that cannot be sent for lack of credits or free VCs waits
+    // for the credit that provides them, which wakes up the router.
+    // Only the flits that could be sent are retried next cycle.
     for (int i = 0; i < m_num_inports; i++) {
+        auto input_unit = m_router->getInputUnit(i);
+        if (input_unit->get_num_flits() == 0)
+            continue;
+
         for (int j = 0; j < m_num_vcs; j++) {
-            if (m_router->getInputUnit(i)->need_stage(j, SA_, nextCycle)) {
+            if (input_unit->need_stage(j, SA_, nextCycle) &&
+                is_send_ready(i, j)) {
                 m_router->schedule_wakeup(Cycles(1));
                 return;
             }
@@ -433,6 +479,22 @@ SwitchAllocator::check_for_wakeup()
     }
 }
 
+// Whether the flit at the head of invc can be sent out of one of the
+// outports it still has to go through
+bool
+SwitchAllocator::is_send_ready(int inport, int invc)
+{
+    const OutInfoTable &out_info =
+        m_router->getInputUnit(inport)->get_out_info(invc);
+    for (int outport : out_info.outports()) {
+        if (is_branch_pending(inport, invc, outport) &&
+            send_allowed(inport, invc, outport, out_info[outport].outvc)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 int
 SwitchAllocator::get_vnet(int invc)
 {
@@ -447,7 +509,33 @@ SwitchAllocator::get_vnet(int invc)
 void
 SwitchAllocator::clear_request_vector()
 {
-    std::fill(m_port_requests.begin(), m_port_requests.end(), std::vector<OutInfo>());
+    for (int inport = 0; inport < m_num_inports; inport++) {
+        if (m_vc_winners[inport] == -1)
+            continue;
+
+        std::fill(m_port_requests[inport].begin(),
+                  m_port_requests[inport].end(), false);
+        m_vc_winners[inport] = -1;
+    }
+}
+
+void
+SwitchAllocator::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_CONTAINER(m_round_robin_invc);
+    SERIALIZE_CONTAINER(m_round_robin_inport);
+}
+
+void
+SwitchAllocator::restoreState(CheckpointIn &cp)
+{
+    UNSERIALIZE_CONTAINER(m_round_robin_invc);
+    UNSERIALIZE_CONTAINER(m_round_robin_inport);
+    fatal_if((int)m_round_robin_invc.size() != m_num_inports ||
+             (int)m_round_robin_inport.size() != m_num_outports,
+             "%s: the checkpoint is of a router with %d inports and %d "
+             "outports.", m_router->name(), m_round_robin_invc.size(),
+             m_round_robin_inport.size());
 }
 
 void
@@ -455,6 +543,8 @@ SwitchAllocator::resetStats()
 {
     m_input_arbiter_activity = 0;
     m_output_arbiter_activity = 0;
+    m_multicast_replications = 0;
+    m_multicast_traversals = 0;
 }
 
 } // namespace garnet
@@ -64,7 +64,7 @@ class SwitchAllocator : public Consumer
     void arbitrate_inports();
     void arbitrate_outports();
     bool send_allowed(int inport, int invc, int outport, int outvc);
-    OutInfo vc_allocate(OutInfo outinfo, int outport, int inport, int invc);
+    int vc_allocate(int outport, int inport, int invc);
 
     inline double
     get_input_arbiter_activity()
@@ -77,22 +77,39 @@ class SwitchAllocator : public Consumer
         return m_output_arbiter_activity;
     }
 
+    inline double
+    get_multicast_replications()
+    {
+        return m_multicast_replications;
+    }
+    inline double
+    get_multicast_traversals()
+    {
+        return m_multicast_traversals;
+    }
+
     void resetStats();
 
-    void reset_outport_availabilities();
-    bool try_claiming_outports(std::vector<OutInfo> requested_out_info);
-    bool is_outport_requested(std::vector<OutInfo> inport_out_info, int outport);
+    void serialize(CheckpointOut &cp) const;
+    void restoreState(CheckpointIn &cp);
+
+    bool is_outport_requested(int inport, int outport);
+    bool is_branch_pending(int inport, int invc, int outport);
+    bool is_send_ready(int inport, int invc);
 
   private:
     int m_num_inports, m_num_outports;
     int m_num_vcs, m_vc_per_vnet;
 
     double m_input_arbiter_activity, m_output_arbiter_activity;
+    // flits created at branch points, and multicast flits sent out
+    double m_multicast_replications, m_multicast_traversals;
 
     Router *m_router;
     std::vector<int> m_round_robin_invc;
     std::vector<int> m_round_robin_inport;
-    std::vector<std::vector<OutInfo>> m_port_requests;
+    // outports requested by the VC winner of each inport, [inport][outport]
+    std::vector<std::vector<bool>> m_port_requests;
     std::vector<int> m_vc_winners;
 };
 
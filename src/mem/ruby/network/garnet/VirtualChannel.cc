@@ -31,6 +31,9 @@
 
 #include "mem/ruby/network/garnet/VirtualChannel.hh"
 
+#include "base/cprintf.hh"
+#include "mem/ruby/network/garnet/GarnetNetwork.hh"
+
 namespace gem5
 {
 
@@ -40,9 +43,9 @@ namespace ruby
 namespace garnet
 {
 
-VirtualChannel::VirtualChannel()
-  : inputBuffer(), m_vc_state(IDLE_, Tick(0)),
-    m_out_info(std::vector<OutInfo>()), m_enqueue_time(INFINITE_)
+VirtualChannel::VirtualChannel(int depth)
+  : inputBuffer(depth), m_vc_state(IDLE_, Tick(0)),
+    m_out_info(), m_enqueue_time(INFINITE_)
 {
 }
 
@@ -52,7 +55,7 @@ VirtualChannel::set_idle(Tick curTime)
     m_vc_state.first = IDLE_;
     m_vc_state.second = curTime;
     m_enqueue_time = Tick(INFINITE_);
-    m_out_info = std::vector<OutInfo>();
+    m_out_info.clear();
 }
 
 void
@@ -86,6 +89,70 @@ VirtualChannel::functionalWrite(Packet *pkt)
     return inputBuffer.functionalWrite(pkt);
 }
 
+void
+VirtualChannel::serialize(CheckpointOut &cp) const
+{
+    VC_state_type state = m_vc_state.first;
+    Tick state_time = m_vc_state.second;
+    SERIALIZE_ENUM(state);
+    SERIALIZE_SCALAR(state_time);
+    SERIALIZE_SCALAR(m_enqueue_time);
+
+    // The branches of the packet in the VC
+    std::vector<int> outports = m_out_info.outports();
+    std::vector<int> outvcs;
+    std::vector<int> vc_classes;
+    for (int outport : outports) {
+        const OutInfo &info = m_out_info[outport];
+        outvcs.push_back(info.outvc);
+        vc_classes.push_back(info.vc_class);
+
+        std::vector<int> dests;
+        for (int ni = info.dests.nextElement(0); ni != -1;
+             ni = info.dests.nextElement(ni + 1)) {
+            dests.push_back(ni);
+        }
+        arrayParamOut(cp, csprintf("dests%d", outport), dests);
+    }
+    SERIALIZE_CONTAINER(outports);
+    SERIALIZE_CONTAINER(outvcs);
+    SERIALIZE_CONTAINER(vc_classes);
+
+    serializeFlits(cp, "flits", inputBuffer.getFlits());
+}
+
+void
+VirtualChannel::restoreState(CheckpointIn &cp, GarnetNetwork *net,
+                             FlitPool *pool)
+{
+    VC_state_type state;
+    Tick state_time;
+    UNSERIALIZE_ENUM(state);
+    UNSERIALIZE_SCALAR(state_time);
+    set_state(state, state_time);
+    UNSERIALIZE_SCALAR(m_enqueue_time);
+
+    std::vector<int> outports;
+    std::vector<int> outvcs;
+    std::vector<int> vc_classes;
+    UNSERIALIZE_CONTAINER(outports);
+    UNSERIALIZE_CONTAINER(outvcs);
+    UNSERIALIZE_CONTAINER(vc_classes);
+    m_out_info.clear();
+    for (int i = 0; i < (int)outports.size(); i++) {
+        std::vector<int> dests;
+        arrayParamIn(cp, csprintf("dests%d", outports[i]), dests);
+        DestMask mask;
+        for (int ni : dests)
+            mask.add(ni);
+        m_out_info.add(outports[i], mask, (VC_class_type)vc_classes[i]);
+        m_out_info[outports[i]].outvc = outvcs[i];
+    }
+
+    for (const auto &flit_state : unserializeFlits(cp, "flits"))
+        inputBuffer.insert(net->restoreFlit(flit_state, pool));
+}
+
 } // namespace garnet
 } // namespace ruby
 } // namespace gem5
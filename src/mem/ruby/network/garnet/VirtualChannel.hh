@@ -36,6 +36,7 @@
 
 #include "mem/ruby/network/garnet/CommonTypes.hh"
 #include "mem/ruby/network/garnet/flitBuffer.hh"
+#include "sim/serialize.hh"
 
 namespace gem5
 {
@@ -46,22 +47,25 @@ namespace ruby
 namespace garnet
 {
 
+class FlitPool;
+class GarnetNetwork;
+
 class VirtualChannel
 {
   public:
-    VirtualChannel();
+    VirtualChannel(int depth);
     ~VirtualChannel() = default;
 
     bool need_stage(flit_stage stage, Tick time);
     void set_idle(Tick curTime);
     void set_active(Tick curTime);
-    void set_out_info(std::vector<OutInfo> out_info) { m_out_info = out_info; }
-    inline std::vector<OutInfo> get_out_info()       { return m_out_info; }
-    void update_out_info(int outport, OutInfo out_info) { m_out_info[outport] = out_info;}
+    void init_out_info(int num_outports) { m_out_info.init(num_outports); }
+    inline OutInfoTable& get_out_info()     { return m_out_info; }
 
     inline Tick get_enqueue_time()          { return m_enqueue_time; }
     inline void set_enqueue_time(Tick time) { m_enqueue_time = time; }
     inline VC_state_type get_state()        { return m_vc_state.first; }
+    inline int get_num_flits() const        { return inputBuffer.getSize(); }
 
     inline bool
     isReady(Tick curTime)
@@ -72,6 +76,8 @@ class VirtualChannel
     inline void
     insertFlit(flit *t_flit)
     {
+        // Credits never let more flits into a VC than its depth
+        assert(!inputBuffer.isFull());
         inputBuffer.insert(t_flit);
     }
 
@@ -97,10 +103,13 @@ class VirtualChannel
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *pkt);
 
+    void serialize(CheckpointOut &cp) const;
+    void restoreState(CheckpointIn &cp, GarnetNetwork *net, FlitPool *pool);
+
   private:
     flitBuffer inputBuffer;
     std::pair<VC_state_type, Tick> m_vc_state;
-    std::vector<OutInfo> m_out_info;
+    OutInfoTable m_out_info;
     Tick m_enqueue_time;
 };
 
@@ -30,8 +30,11 @@
 
 #include "mem/ruby/network/garnet/flit.hh"
 
+#include "base/cprintf.hh"
 #include "base/intmath.hh"
 #include "debug/RubyNetwork.hh"
+#include "mem/ruby/network/garnet/Credit.hh"
+#include "mem/ruby/network/garnet/FlitPool.hh"
 
 namespace gem5
 {
@@ -43,21 +46,23 @@ namespace garnet
 {
 
 // Constructor for the flit
-flit::flit(int packet_id, int id, int  vc, int vnet,
-    std::vector<RouteInfo> routes, int size, int eff_dest,
-    std::vector<MsgPtr> msg_ptrs, int MsgSize, uint32_t bWidth, Tick curTime)
+flit::flit(int packet_id, int id, int  vc, int vnet, PacketInfoPtr packet,
+    const DestMask &dests, int size, int MsgSize, uint32_t bWidth,
+    Tick curTime)
 {
     m_size = size;
-    m_eff_dest = eff_dest;
-    m_msg_ptrs = msg_ptrs;
+    m_packet = std::move(packet);
+    m_dest_mask = dests;
+    // initialize hops_traversed to -1
+    // so that the first router increments it to 0
+    m_hops_traversed = -1;
     m_enqueue_time = curTime;
     m_dequeue_time = curTime;
     m_time = curTime;
-    m_packet_id = id;
+    m_packet_id = packet_id;
     m_id = id;
     m_vnet = vnet;
     m_vc = vc;
-    m_routes = routes;
     m_stage.first = I_;
     m_stage.second = curTime;
     m_width = bWidth;
@@ -85,10 +90,13 @@ flit::serialize(int ser_id, int parts, uint32_t bWidth)
     int new_size = (int)divCeil((float)msgSize, (float)bWidth);
     assert(new_id < new_size);
 
-    flit *fl = new flit(m_packet_id, new_id, m_vc, m_vnet, m_routes,
-                    new_size, m_eff_dest, m_msg_ptrs, msgSize, bWidth, m_time);
+    // Data flits are always allocated from the pool of their network
+    assert(m_pool);
+    flit *fl = m_pool->create(m_packet_id, new_id, m_vc, m_vnet, m_packet,
+                    m_dest_mask, new_size, msgSize, bWidth, m_time);
     fl->set_enqueue_time(m_enqueue_time);
     fl->set_src_delay(src_delay);
+    fl->set_hops_traversed(m_hops_traversed);
     return fl;
 }
 
@@ -100,10 +108,13 @@ flit::deserialize(int des_id, int num_flits, uint32_t bWidth)
     int new_size = (int)divCeil((float)msgSize, (float)bWidth);
     assert(new_id < new_size);
 
-    flit *fl = new flit(m_packet_id, new_id, m_vc, m_vnet, m_routes,
-                    new_size, m_eff_dest, m_msg_ptrs, msgSize, bWidth, m_time);
+    // Data flits are always allocated from the pool of their network
+    assert(m_pool);
+    flit *fl = m_pool->create(m_packet_id, new_id, m_vc, m_vnet, m_packet,
+                    m_dest_mask, new_size, msgSize, bWidth, m_time);
     fl->set_enqueue_time(m_enqueue_time);
     fl->set_src_delay(src_delay);
+    fl->set_hops_traversed(m_hops_traversed);
     return fl;
 }
 
@@ -118,12 +129,12 @@ flit::print(std::ostream& out) const
     out << "Size=" << m_size << " ";
     out << "Vnet=" << m_vnet << " ";
     out << "VC=" << m_vc << " ";
-    out << "Src NI=" << m_routes[0].src_ni << " ";
-    out << "Src Router=" << m_routes[0].src_router << " ";
-    out << "Dest NIs=";
-    for (auto r : m_routes) out << r.dest_ni << " ";
-    out << "Dest Routers=";
-    for (auto r : m_routes) out << r.dest_router << " ";
+    if (m_packet) {
+        out << "Src NI=" << m_packet->route.src_ni << " ";
+        out << "Src Router=" << m_packet->route.src_router << " ";
+        out << "Dest NIs=" << m_dest_mask << " ";
+        out << "Dest Router=" << m_packet->route.dest_router << " ";
+    }
     out << "Set Time=" << m_time << " ";
     out << "Width=" << m_width<< " ";
     out << "]";
@@ -132,16 +143,134 @@ flit::print(std::ostream& out) const
 bool
 flit::functionalRead(Packet *pkt, WriteMask &mask)
 {
-    Message *msg = m_msg_ptrs[0].get();
-    /* the [0] is a hack; all msg_ptrs need to be accounted for */
-    return msg->functionalRead(pkt, mask);
+    Message *msg = m_packet->msg_ptr.get();
+    return msg && msg->functionalRead(pkt, mask);
 }
 
 bool
 flit::functionalWrite(Packet *pkt)
 {
-    Message *msg = m_msg_ptrs[0].get();
-    return msg->functionalWrite(pkt);
+    Message *msg = m_packet->msg_ptr.get();
+    return msg && msg->functionalWrite(pkt);
+}
+
+FlitState::FlitState(flit *t_flit)
+    : packet_id(t_flit->getPacketID()), id(t_flit->get_id()),
+      vnet(t_flit->get_vnet()), vc(t_flit->get_vc()),
+      size(t_flit->get_size()), msg_size(t_flit->msgSize),
+      width(t_flit->m_width), type(t_flit->get_type()),
+      hops(t_flit->get_hops_traversed()), outport(t_flit->get_outport()),
+      multiauth(t_flit->is_multiauth()),
+      enqueue_time(t_flit->get_enqueue_time()),
+      dequeue_time(t_flit->get_dequeue_time()), time(t_flit->get_time()),
+      src_delay(t_flit->get_src_delay()),
+      stage(t_flit->get_stage().first),
+      stage_time(t_flit->get_stage().second)
+{
+    if (type == CREDIT_) {
+        free_signal = static_cast<Credit *>(t_flit)->is_free_signal();
+        return;
+    }
+
+    const DestMask &mask = t_flit->get_dest_mask();
+    for (int ni = mask.nextElement(0); ni != -1; ni = mask.nextElement(ni + 1))
+        dests.push_back(ni);
+
+    const RouteInfo &route = t_flit->get_route();
+    route_vnet = route.vnet;
+    src_ni = route.src_ni;
+    src_router = route.src_router;
+    dest_ni = route.dest_ni;
+    dest_router = route.dest_router;
+}
+
+void
+FlitState::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_ENUM(type);
+    SERIALIZE_SCALAR(vc);
+    SERIALIZE_SCALAR(time);
+    if (type == CREDIT_) {
+        SERIALIZE_SCALAR(free_signal);
+        return;
+    }
+
+    SERIALIZE_SCALAR(packet_id);
+    SERIALIZE_SCALAR(id);
+    SERIALIZE_SCALAR(vnet);
+    SERIALIZE_SCALAR(size);
+    SERIALIZE_SCALAR(msg_size);
+    SERIALIZE_SCALAR(width);
+    SERIALIZE_SCALAR(hops);
+    SERIALIZE_SCALAR(outport);
+    SERIALIZE_SCALAR(multiauth);
+    SERIALIZE_SCALAR(enqueue_time);
+    SERIALIZE_SCALAR(dequeue_time);
+    SERIALIZE_SCALAR(src_delay);
+    SERIALIZE_ENUM(stage);
+    SERIALIZE_SCALAR(stage_time);
+    SERIALIZE_CONTAINER(dests);
+    SERIALIZE_SCALAR(route_vnet);
+    SERIALIZE_SCALAR(src_ni);
+    SERIALIZE_SCALAR(src_router);
+    SERIALIZE_SCALAR(dest_ni);
+    SERIALIZE_SCALAR(dest_router);
+}
+
+void
+FlitState::unserialize(CheckpointIn &cp)
+{
+    UNSERIALIZE_ENUM(type);
+    UNSERIALIZE_SCALAR(vc);
+    UNSERIALIZE_SCALAR(time);
+    if (type == CREDIT_) {
+        UNSERIALIZE_SCALAR(free_signal);
+        return;
+    }
+
+    UNSERIALIZE_SCALAR(packet_id);
+    UNSERIALIZE_SCALAR(id);
+    UNSERIALIZE_SCALAR(vnet);
+    UNSERIALIZE_SCALAR(size);
+    UNSERIALIZE_SCALAR(msg_size);
+    UNSERIALIZE_SCALAR(width);
+    UNSERIALIZE_SCALAR(hops);
+    UNSERIALIZE_SCALAR(outport);
+    UNSERIALIZE_SCALAR(multiauth);
+    UNSERIALIZE_SCALAR(enqueue_time);
+    UNSERIALIZE_SCALAR(dequeue_time);
+    UNSERIALIZE_SCALAR(src_delay);
+    UNSERIALIZE_ENUM(stage);
+    UNSERIALIZE_SCALAR(stage_time);
+    UNSERIALIZE_CONTAINER(dests);
+    UNSERIALIZE_SCALAR(route_vnet);
+    UNSERIALIZE_SCALAR(src_ni);
+    UNSERIALIZE_SCALAR(src_router);
+    UNSERIALIZE_SCALAR(dest_ni);
+    UNSERIALIZE_SCALAR(dest_router);
+}
+
+void
+serializeFlits(CheckpointOut &cp, const std::string &name,
+               const std::vector<flit *> &flits)
+{
+    Serializable::ScopedCheckpointSection sec(cp, name);
+    int num_flits = flits.size();
+    SERIALIZE_SCALAR(num_flits);
+    for (int i = 0; i < num_flits; i++)
+        FlitState(flits[i]).serializeSection(cp, csprintf("flit%d", i));
+}
+
+std::vector<FlitState>
+unserializeFlits(CheckpointIn &cp, const std::string &name)
+{
+    Serializable::ScopedCheckpointSection sec(cp, name);
+    int num_flits;
+    UNSERIALIZE_SCALAR(num_flits);
+    std::vector<FlitState> flits(num_flits);
+    for (int i = 0; i < num_flits; i++)
+        flits[i].unserializeSection(cp, csprintf("flit%d", i));
+    return flits;
 }
 
 } // namespace garnet
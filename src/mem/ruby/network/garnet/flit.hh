@@ -31,12 +31,17 @@
 #ifndef __MEM_RUBY_NETWORK_GARNET_0_FLIT_HH__
 #define __MEM_RUBY_NETWORK_GARNET_0_FLIT_HH__
 
+#include <atomic>
 #include <cassert>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "base/types.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
+#include "sim/serialize.hh"
 
 namespace gem5
 {
@@ -47,20 +52,53 @@ namespace ruby
 namespace garnet
 {
 
+// Delivery of a message to all its destinations, shared by the packets
+// that carry it: one multicast packet, one unicast packet per
+// destination, or both when the message is split.
+struct DeliveryInfo
+{
+    DeliveryInfo(Tick time, int num_dests, MulticastPath how)
+        : issue_time(time), fan_out(num_dests), path(how),
+          pending(num_dests)
+    {}
+
+    Tick issue_time; // the message is ready at the source NI
+    int fan_out;
+    MulticastPath path;
+    // destinations that have not received the tail yet; they may be
+    // ejected by NIs of different partitions
+    std::atomic<int> pending;
+};
+
+// Per-packet state that is shared by all the flits of a packet and, for
+// a multicast packet, by all the branches of its multicast tree.
+// Flits only hold a reference to it, so replicating a flit at a branch
+// point copies neither the route nor the message. The message is
+// materialized per destination when the packet is ejected.
+// Packets restored from a checkpoint have neither message nor delivery.
+struct PacketInfo
+{
+    RouteInfo route;
+    MsgPtr msg_ptr;
+    std::shared_ptr<DeliveryInfo> delivery;
+};
+
+typedef std::shared_ptr<const PacketInfo> PacketInfoPtr;
+
+class FlitPool;
+
 class flit
 {
   public:
     flit() {}
-    flit(int packet_id, int id, int vc, int vnet,
-         std::vector<RouteInfo> routes, int size, int eff_dest,
-         std::vector<MsgPtr> msg_ptrs, int MsgSize,
-	 uint32_t bWidth, Tick curTime);
+    flit(int packet_id, int id, int vc, int vnet, PacketInfoPtr packet,
+         const DestMask &dests, int size, int MsgSize, uint32_t bWidth,
+         Tick curTime);
 
     virtual ~flit(){};
 
     int get_outport() {return m_outport; }
     int get_size() { return m_size; }
-    int get_eff_dest() { return m_eff_dest; }
     Tick get_enqueue_time() { return m_enqueue_time; }
     Tick get_dequeue_time() { return m_dequeue_time; }
     int getPacketID() { return m_packet_id; }
@@ -68,28 +106,30 @@ class flit
     Tick get_time() { return m_time; }
     int get_vnet() { return m_vnet; }
     int get_vc() { return m_vc; }
-    RouteInfo get_route(int i) { return m_routes[i]; }
-    std::vector<RouteInfo> get_routes() { return m_routes; }
-    int get_num_routes() { return m_routes.size(); }
-    MsgPtr& get_msg_ptr() { return m_msg_ptrs[0]; }
-    std::vector<MsgPtr>& get_msg_ptrs() { return m_msg_ptrs; }
+    const PacketInfoPtr& get_packet() { return m_packet; }
+    const RouteInfo& get_route() { return m_packet->route; }
+    const DestMask& get_dest_mask() { return m_dest_mask; }
+    bool is_multicast() { return m_packet->route.isMulticast(); }
+    const MsgPtr& get_msg_ptr() { return m_packet->msg_ptr; }
+    // Restored from a checkpoint without its message (see FlitState)
+    bool is_ghost() { return !m_packet->msg_ptr; }
+    int get_hops_traversed() { return m_hops_traversed; }
     flit_type get_type() { return m_type; }
     std::pair<flit_stage, Tick> get_stage() { return m_stage; }
     Tick get_src_delay() { return src_delay; }
     bool is_multiauth() { return m_is_multiauth; }
 
     void set_outport(int port) { m_outport = port; }
-    void set_eff_dest(int eff_dest) { m_eff_dest = eff_dest; }
     void set_time(Tick time) { m_time = time; }
     void set_vc(int vc) { m_vc = vc; }
     void set_src_delay(Tick delay) { src_delay = delay; }
     void set_dequeue_time(Tick time) { m_dequeue_time = time; }
     void set_enqueue_time(Tick time) { m_enqueue_time = time; }
-    void set_msg_ptrs(std::vector<MsgPtr> msg_ptrs) { m_msg_ptrs = msg_ptrs;}
-    void set_routes(std::vector<RouteInfo> routes) { m_routes = routes;}
+    void set_dest_mask(const DestMask &dests) { m_dest_mask = dests; }
+    void set_hops_traversed(int hops) { m_hops_traversed = hops; }
     void set_is_multiauth(bool is_multiauth) { m_is_multiauth = is_multiauth; }
 
-    void increment_hops() { for (auto r : m_routes) r.hops_traversed++; }
+    void increment_hops() { m_hops_traversed++; }
     virtual void print(std::ostream& out) const;
 
     bool
@@ -131,17 +171,22 @@ class flit
     int m_id;
     int m_vnet;
     int m_vc;
-    std::vector<RouteInfo> m_routes;
+    PacketInfoPtr m_packet;
+    // destination NIs still to be served by this flit
+    DestMask m_dest_mask;
+    int m_hops_traversed;
     int m_size;
-    int m_eff_dest;
     Tick m_enqueue_time, m_dequeue_time;
     Tick m_time;
     flit_type m_type;
-    std::vector<MsgPtr> m_msg_ptrs;
-    int m_outport;
-    Tick src_delay;
+    int m_outport = -1;
+    Tick src_delay = 0;
     std::pair<flit_stage, Tick> m_stage;
     bool m_is_multiauth = false;
+
+    // Pool the flit was allocated from, if any
+    FlitPool *m_pool = nullptr;
+    friend class FlitPool;
 };
 
 inline std::ostream&
@@ -152,6 +197,57 @@ operator<<(std::ostream& out, const flit& obj)
     return out;
 }
 
+// A flit or credit in a checkpoint of the network.
+//
+// Ruby messages cannot be serialized, and the protocol state they belong
+// to is rebuilt from the cache trace on restore anyway. The message of a
+// packet is therefore not saved: a restored flit is a ghost that takes
+// the same buffers, VCs and links as the original, so that the network
+// restarts at the load it was checkpointed at, and is dropped by the
+// destination NI. Neither is the NetDest of the route, which routing
+// does not use.
+struct FlitState : public Serializable
+{
+    FlitState() = default;
+    FlitState(flit *t_flit);
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+    int packet_id = 0;
+    int id = 0;
+    int vnet = 0;
+    int vc = 0;
+    int size = 0;
+    int msg_size = 0;
+    uint32_t width = 0;
+    flit_type type = HEAD_TAIL_;
+    bool free_signal = false; // credits only
+    int hops = 0;
+    int outport = 0;
+    bool multiauth = false;
+    Tick enqueue_time = 0;
+    Tick dequeue_time = 0;
+    Tick time = 0;
+    Tick src_delay = 0;
+    flit_stage stage = I_;
+    Tick stage_time = 0;
+    std::vector<int> dests;
+
+    // Route of the packet
+    int route_vnet = 0;
+    int src_ni = 0;
+    int src_router = 0;
+    int dest_ni = 0;
+    int dest_router = 0;
+};
+
+// Save the flits of a buffer, in order, in section name
+void serializeFlits(CheckpointOut &cp, const std::string &name,
+                    const std::vector<flit *> &flits);
+std::vector<FlitState> unserializeFlits(CheckpointIn &cp,
+                                        const std::string &name);
+
 } // namespace garnet
 } // namespace ruby
 } // namespace gem5
@@ -32,6 +32,7 @@
 #define __MEM_RUBY_NETWORK_GARNET_0_FLITBUFFER_HH__
 
 #include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <vector>
 
@@ -47,6 +48,11 @@ namespace ruby
 namespace garnet
 {
 
+// flitBuffer is a FIFO of flits kept in a ring of power-of-two capacity.
+// The capacity is set at construction to the most flits the buffer is
+// expected to hold (e.g., the depth of a VC), so inserting and removing
+// flits does not allocate. A buffer that turns out to be too small
+// doubles its ring once, and keeps it from then on.
 class flitBuffer
 {
   public:
@@ -58,33 +64,55 @@ class flitBuffer
     void print(std::ostream& out) const;
     bool isFull();
     void setMaxSize(int maximum);
-    int getSize() const { return m_buffer.size(); }
+    int getSize() const { return m_size; }
+    int getCapacity() const { return m_ring.size(); }
 
     flit *
     getTopFlit()
     {
-        flit *f = m_buffer.front();
-        m_buffer.pop_front();
+        assert(m_size > 0);
+        flit *f = m_ring[m_head];
+        m_head = (m_head + 1) & m_mask;
+        m_size--;
         return f;
     }
 
     flit *
     peekTopFlit()
     {
-        return m_buffer.front();
+        assert(m_size > 0);
+        return m_ring[m_head];
     }
 
     void
     insert(flit *flt)
     {
-        m_buffer.push_back(flt);
+        if (m_size == m_ring.size())
+            grow(2 * m_ring.size());
+        m_ring[(m_head + m_size) & m_mask] = flt;
+        m_size++;
     }
 
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *pkt);
 
+    // The flits in the buffer, oldest first
+    std::vector<flit *> getFlits() const;
+
   private:
-    std::deque<flit *> m_buffer;
+    // Resize the ring to at least num_flits slots, keeping the flits
+    void grow(unsigned num_flits);
+
+    flit *
+    at(unsigned i) const
+    {
+        return m_ring[(m_head + i) & m_mask];
+    }
+
+    std::vector<flit *> m_ring;
+    unsigned m_head;
+    unsigned m_size;
+    unsigned m_mask;
     int max_size;
 };
 
@@ -207,13 +207,29 @@ PerfectSwitch::operateMessageBuffer(MessageBuffer *buffer, int vnet)
                                          m_network_ptr->isVNetOrdered(vnet),
                                          output_links);
 
+        bool is_multicast = net_msg_ptr->getDestination().count() > 1;
+        if (is_multicast && !m_network_ptr->isMulticastEnabled()) {
+            splitPerDestination(output_links);
+            is_multicast = false;
+        }
+
         // Check for resources - for all outgoing queues
+        // The copies of the message sent down the same link are next to
+        // each other.
         bool enough = true;
         for (int i = 0; i < output_links.size(); i++) {
             int outgoing = output_links[i].m_link_id;
             OutputPort &out_port = m_out[outgoing];
 
-            if (!out_port.buffers[vnet]->areNSlotsAvailable(1, current_time))
+            int copies = 1;
+            while (i + 1 < output_links.size() &&
+                   output_links[i + 1].m_link_id == outgoing) {
+                copies++;
+                i++;
+            }
+
+            if (!out_port.buffers[vnet]->areNSlotsAvailable(copies,
+                                                            current_time))
                 enough = false;
 
             DPRINTF(RubyNetwork, "Checking if node is blocked ..."
@@ -230,18 +246,7 @@ PerfectSwitch::operateMessageBuffer(MessageBuffer *buffer, int vnet)
             break; // go to next incoming port
         }
 
-        MsgPtr unmodified_msg_ptr;
-
-        if (output_links.size() > 1) {
-            // If we are sending this message down more than one link
-            // (size>1), we need to make a copy of the message so each
-            // branch can have a different internal destination we need
-            // to create an unmodified MsgPtr because the MessageBuffer
-            // enqueue func will modify the message
-
-            // This magic line creates a private copy of the message
-            unmodified_msg_ptr = msg_ptr->clone();
-        }
+        MsgPtr unmodified_msg_ptr = msg_ptr;
 
         // Dequeue msg
         buffer->dequeue(current_time);
@@ -252,9 +257,14 @@ PerfectSwitch::operateMessageBuffer(MessageBuffer *buffer, int vnet)
             int outgoing = output_links[i].m_link_id;
             OutputPort &out_port = m_out[outgoing];
 
-            if (i > 0) {
-                // create a private copy of the unmodified message
+            // Each branch needs its own copy of the message, as the
+            // destinations differ and the MessageBuffer enqueue func
+            // modifies the message. The message itself goes down the last
+            // branch, so the copies are made before it is modified.
+            if (i < output_links.size() - 1) {
                 msg_ptr = unmodified_msg_ptr->clone();
+            } else {
+                msg_ptr = unmodified_msg_ptr;
             }
 
             // Change the internal destination set of the message so it
@@ -262,6 +272,14 @@ PerfectSwitch::operateMessageBuffer(MessageBuffer *buffer, int vnet)
             net_msg_ptr = msg_ptr.get();
             net_msg_ptr->getDestination() = output_links[i].m_destinations;
 
+            // The branch is charged once on the link, whatever the number
+            // of destinations it serves
+            if (is_multicast) {
+                m_switch->switchStats.m_multicast_traversals++;
+                m_switch->switchStats.m_multicast_unicast_traversals +=
+                    output_links[i].m_destinations.count();
+            }
+
             // Enqeue msg
             DPRINTF(RubyNetwork, "Enqueuing net msg from "
                     "inport[%d][%d] to outport [%d][%d].\n",
@@ -273,6 +291,31 @@ PerfectSwitch::operateMessageBuffer(MessageBuffer *buffer, int vnet)
     }
 }
 
+// Without multicast, a message to several destinations is sent as one
+// message per destination, each of which takes its own share of the
+// bandwidth of every link it crosses.
+void
+PerfectSwitch::splitPerDestination(
+    std::vector<BaseRoutingUnit::RouteInfo> &output_links)
+{
+    static thread_local std::vector<BaseRoutingUnit::RouteInfo>
+        unicast_links;
+
+    unicast_links.clear();
+    for (auto &link : output_links) {
+        NetDest dests = link.m_destinations;
+        while (!dests.isEmpty()) {
+            MachineID dest = dests.smallestElement();
+            dests.remove(dest);
+
+            NetDest unicast_dest;
+            unicast_dest.add(dest);
+            unicast_links.emplace_back(unicast_dest, link.m_link_id);
+        }
+    }
+    output_links.swap(unicast_links);
+}
+
 void
 PerfectSwitch::wakeup()
 {
@@ -54,6 +54,7 @@
 
 #include "mem/ruby/common/Consumer.hh"
 #include "mem/ruby/common/TypeDefines.hh"
+#include "mem/ruby/network/simple/routing/BaseRoutingUnit.hh"
 
 namespace gem5
 {
@@ -100,6 +101,8 @@ class PerfectSwitch : public Consumer
 
     void operateVnet(int vnet);
     void operateMessageBuffer(MessageBuffer *b, int vnet);
+    void splitPerDestination(
+        std::vector<BaseRoutingUnit::RouteInfo> &output_links);
 
     const SwitchID m_switch_id;
     Switch * const m_switch;
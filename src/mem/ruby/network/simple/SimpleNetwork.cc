@@ -61,6 +61,7 @@ namespace ruby
 SimpleNetwork::SimpleNetwork(const Params &p)
     : Network(p), m_buffer_size(p.buffer_size),
       m_endpoint_bandwidth(p.endpoint_bandwidth),
+      m_enable_multicast(p.enable_multicast),
       networkStats(this)
 {
     // record the routers
@@ -188,6 +189,16 @@ SimpleNetwork::regStats()
             *(networkStats.m_msg_counts[(unsigned int) type]) *
                 statistics::constant(Network::MessageSizeType_to_int(type));
     }
+
+    for (auto& it : m_switches) {
+        networkStats.m_multicast_traversals +=
+            it.second->getMulticastTraversals();
+        networkStats.m_multicast_unicast_traversals +=
+            it.second->getMulticastUnicastTraversals();
+    }
+    networkStats.m_multicast_traversal_savings =
+        networkStats.m_multicast_unicast_traversals -
+        networkStats.m_multicast_traversals;
 }
 
 void
@@ -256,7 +267,17 @@ SimpleNetwork::functionalWrite(Packet *pkt)
 
 SimpleNetwork::
 NetworkStats::NetworkStats(statistics::Group *parent)
-    : statistics::Group(parent)
+    : statistics::Group(parent),
+      m_multicast_traversals(this, "multicast_traversals",
+          statistics::units::Count::get(),
+          "Link traversals of messages to several destinations"),
+      m_multicast_unicast_traversals(this, "multicast_unicast_traversals",
+          statistics::units::Count::get(),
+          "Link traversals of the same messages sent as one "
+          "message per destination"),
+      m_multicast_traversal_savings(this, "multicast_traversal_savings",
+          statistics::units::Count::get(),
+          "Link traversals saved by multicast")
 {
 
 }
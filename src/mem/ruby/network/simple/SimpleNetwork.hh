@@ -70,6 +70,9 @@ class SimpleNetwork : public Network
 
     int getBufferSize() { return m_buffer_size; }
     int getEndpointBandwidth() { return m_endpoint_bandwidth; }
+    bool isMulticastEnabled() const { return m_enable_multicast; }
+    // Switch between multicast and multiple unicast between sweep points
+    void setMulticastEnabled(bool enable) { m_enable_multicast = enable; }
 
     void collateStats();
     void regStats();
@@ -106,6 +109,7 @@ class SimpleNetwork : public Network
     std::vector<MessageBuffer*> m_int_link_buffers;
     const int m_buffer_size;
     const int m_endpoint_bandwidth;
+    bool m_enable_multicast;
 
 
     struct NetworkStats : public statistics::Group
@@ -115,6 +119,12 @@ class SimpleNetwork : public Network
         //Statistical variables
         statistics::Formula* m_msg_counts[MessageSizeType_NUM];
         statistics::Formula* m_msg_bytes[MessageSizeType_NUM];
+
+        // Link traversals of the messages to several destinations, and
+        // the traversals of one message per destination instead
+        statistics::Formula m_multicast_traversals;
+        statistics::Formula m_multicast_unicast_traversals;
+        statistics::Formula m_multicast_traversal_savings;
     } networkStats;
 };
 
@@ -40,7 +40,7 @@ from m5.params import *
 from m5.proxy import *
 
 from m5.util import fatal
-from m5.SimObject import SimObject
+from m5.SimObject import SimObject, PyBindMethod
 from m5.objects.Network import RubyNetwork
 from m5.objects.BasicRouter import BasicRouter
 from m5.objects.MessageBuffer import MessageBuffer
@@ -51,12 +51,19 @@ class SimpleNetwork(RubyNetwork):
     cxx_header = "mem/ruby/network/simple/SimpleNetwork.hh"
     cxx_class = "gem5::ruby::SimpleNetwork"
 
+    cxx_exports = [PyBindMethod("setMulticastEnabled")]
+
     buffer_size = Param.Int(
         0,
         "default internal buffer size for links and\
                                 routers; 0 indicates infinite buffering",
     )
     endpoint_bandwidth = Param.Int(1000, "bandwidth adjustment factor")
+    enable_multicast = Param.Bool(
+        True,
+        "send a message to several destinations as a tree, with one copy "
+        "per link; otherwise as one message per destination",
+    )
 
     physical_vnets_channels = VectorParam.Int(
         [],
@@ -223,7 +223,13 @@ Switch::functionalWrite(Packet *pkt)
 Switch::
 SwitchStats::SwitchStats(statistics::Group *parent)
     : statistics::Group(parent),
-      m_avg_utilization(this, "percent_links_utilized")
+      m_avg_utilization(this, "percent_links_utilized"),
+      m_multicast_traversals(this, "multicast_traversals",
+          statistics::units::Count::get(),
+          "Link traversals of messages to several destinations"),
+      m_multicast_unicast_traversals(this, "multicast_unicast_traversals",
+          statistics::units::Count::get(),
+          "Destinations carried by those messages")
 {
 
 }
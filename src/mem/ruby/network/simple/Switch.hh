@@ -101,6 +101,10 @@ class Switch : public BasicRouter
     void regStats();
     const statistics::Formula & getMsgCount(unsigned int type) const
     { return *(switchStats.m_msg_counts[type]); }
+    const statistics::Scalar & getMulticastTraversals() const
+    { return switchStats.m_multicast_traversals; }
+    const statistics::Scalar & getMulticastUnicastTraversals() const
+    { return switchStats.m_multicast_unicast_traversals; }
 
     void print(std::ostream& out) const;
     void init_net_ptr(SimpleNetwork* net_ptr) { m_network_ptr = net_ptr; }
@@ -138,6 +142,11 @@ class Switch : public BasicRouter
         statistics::Formula m_avg_utilization;
         statistics::Formula* m_msg_counts[MessageSizeType_NUM];
         statistics::Formula* m_msg_bytes[MessageSizeType_NUM];
+
+        // Messages to several destinations sent down an output link, and
+        // the destinations they carried
+        statistics::Scalar m_multicast_traversals;
+        statistics::Scalar m_multicast_unicast_traversals;
     } switchStats;
 };
 
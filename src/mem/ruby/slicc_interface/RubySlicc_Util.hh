@@ -55,6 +55,8 @@
 #include "mem/ruby/common/Address.hh"
 #include "mem/ruby/common/BoolVec.hh"
 #include "mem/ruby/common/DataBlock.hh"
+#include "mem/ruby/common/DeliveryTracker.hh"
+#include "mem/ruby/common/NetDest.hh"
 #include "mem/ruby/common/TypeDefines.hh"
 #include "mem/ruby/common/WriteMask.hh"
 #include "mem/ruby/protocol/RubyRequestType.hh"
@@ -316,6 +318,34 @@ countBoolVec(BoolVec bVec)
     return count;
 }
 
+/**
+ * The destinations a traffic generator picked for the message of a
+ * packet (see DeliverySenderState), or default_dest if it picked none.
+ */
+inline NetDest
+getPacketDestination(PacketPtr pkt, MachineType mtype,
+                     MachineID default_dest)
+{
+    NetDest dest;
+    DeliverySenderState *state =
+        pkt ? pkt->findNextSenderState<DeliverySenderState>() : nullptr;
+    if (state && !state->destinations.empty()) {
+        for (NodeID id : state->destinations)
+            dest.add(MachineID(mtype, id));
+    } else {
+        dest.add(default_dest);
+    }
+    return dest;
+}
+
+inline DeliveryTracker
+getDeliveryTracker(PacketPtr pkt)
+{
+    DeliverySenderState *state =
+        pkt ? pkt->findNextSenderState<DeliverySenderState>() : nullptr;
+    return state ? state->tracker : DeliveryTracker();
+}
+
 } // namespace ruby
 } // namespace gem5
 
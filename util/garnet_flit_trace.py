@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2026 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Read the flit traces written by a GarnetNetwork with flit_trace_file set
+(--garnet-flit-trace) and report the path and latency breakdown of the
+packets.
+
+    garnet_flit_trace.py m5out/flits.bin summary
+    garnet_flit_trace.py m5out/flits.bin path 1234
+    garnet_flit_trace.py m5out/flits.bin csv packets.csv
+
+Latencies are split into the time a message waits at its source NI
+(queueing and tag computation), the time its head flit spends in routers
+(from the write into an input VC to the switch grant), and the remainder,
+which is spent on links and in the destination NI.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+from collections import defaultdict
+
+HEADER = struct.Struct("=4sIII")
+RECORD = struct.Struct("=QIHBBHBBBBH")
+MAGIC = b"GFTR"
+VERSION = 1
+
+ENQUEUE, INJECT, ROUTER_IN, ROUTER_OUT, BRANCH, EJECT = range(6)
+EVENT_NAMES = ["enqueue", "inject", "router_in", "router_out", "branch",
+               "eject"]
+NO_PORT = 0xFF
+
+
+# Records read at once; traces are streamed rather than read whole
+CHUNK_RECORDS = 65536
+
+
+def read_records(path):
+    with open(path, "rb") as f:
+        header = f.read(HEADER.size)
+        if len(header) < HEADER.size:
+            sys.exit(f"{path}: not a flit trace")
+        magic, version, record_size, _ = HEADER.unpack(header)
+        if magic != MAGIC:
+            sys.exit(f"{path}: not a flit trace")
+        if version != VERSION or record_size != RECORD.size:
+            sys.exit(f"{path}: unsupported trace version {version}")
+        while True:
+            chunk = f.read(RECORD.size * CHUNK_RECORDS)
+            # A trace cut short by a crash may end in a partial record
+            chunk = chunk[: len(chunk) - len(chunk) % RECORD.size]
+            if not chunk:
+                break
+            yield from RECORD.iter_unpack(chunk)
+
+
+def load_packets(path, head_only):
+    """Group the records by packet, in tick order."""
+    packets = defaultdict(list)
+    for rec in read_records(path):
+        tick, packet, flit, event, vnet, node, inp, outp, vc, _, dests = rec
+        if head_only and flit != 0:
+            continue
+        packets[packet].append(
+            (tick, event, flit, vnet, node, inp, outp, vc, dests)
+        )
+    for events in packets.values():
+        events.sort(key=lambda e: (e[0], e[1]))
+    return packets
+
+
+def breakdown(events):
+    """Latency breakdown of the head flit of a packet."""
+    head = [e for e in events if e[2] == 0]
+    enqueue = next((e[0] for e in head if e[1] == ENQUEUE), None)
+    inject = next((e[0] for e in head if e[1] == INJECT), None)
+    ejects = [(e[4], e[0]) for e in head if e[1] == EJECT]
+    if inject is None or not ejects:
+        return None
+
+    # A copy of the flit enters a router once per inport, so the grants at
+    # a router pair up with the write into its input VC. A visit lasts
+    # until the last branch is granted.
+    visits = {}
+    for tick, event, _, _, node, inp, _, _, _ in head:
+        if event == ROUTER_IN:
+            visits[(node, inp)] = [tick, tick]
+        elif event in (ROUTER_OUT, BRANCH) and (node, inp) in visits:
+            visits[(node, inp)][1] = tick
+    router_ticks = sum(last - first for first, last in visits.values())
+
+    source_ticks = inject - enqueue if enqueue is not None else 0
+    last_eject = max(t for _, t in ejects)
+    network_ticks = last_eject - inject
+    return {
+        "vnet": head[0][3],
+        "src": next(e[4] for e in head if e[1] == INJECT),
+        "dests": len(ejects),
+        "router_visits": len(visits),
+        "source_ticks": source_ticks,
+        "router_ticks": router_ticks,
+        "network_ticks": network_ticks,
+        "total_ticks": source_ticks + network_ticks,
+        "ejects": ejects,
+        "inject": inject,
+    }
+
+
+def cmd_summary(args):
+    packets = load_packets(args.trace, head_only=True)
+    totals = defaultdict(lambda: defaultdict(int))
+    for events in packets.values():
+        b = breakdown(events)
+        if b is None:
+            continue
+        kind = "multicast" if b["dests"] > 1 else "unicast"
+        for key in (b["vnet"], "all"):
+            t = totals[(key, kind)]
+            t["packets"] += 1
+            t["deliveries"] += b["dests"]
+            for field in ("router_visits", "source_ticks", "router_ticks",
+                          "network_ticks", "total_ticks"):
+                t[field] += b[field]
+
+    print(f"{len(packets)} packets in trace")
+    print(f"{'vnet':>5} {'kind':>10} {'packets':>9} {'dests':>6} "
+          f"{'visits':>7} {'source':>10} {'router':>10} {'link+ni':>10} "
+          f"{'total':>10}")
+    for (key, kind), t in sorted(totals.items(), key=lambda i: str(i[0])):
+        n = t["packets"]
+        link = t["network_ticks"] - t["router_ticks"]
+        print(f"{key:>5} {kind:>10} {n:>9} {t['deliveries'] / n:>6.2f} "
+              f"{t['router_visits'] / n:>7.2f} "
+              f"{t['source_ticks'] / n:>10.1f} "
+              f"{t['router_ticks'] / n:>10.1f} "
+              f"{link / n:>10.1f} {t['total_ticks'] / n:>10.1f}")
+    print("(average ticks per packet; router time is summed over all the "
+          "routers a multicast tree visits)")
+
+
+def port(p):
+    return "-" if p == NO_PORT else str(p)
+
+
+def cmd_path(args):
+    packets = load_packets(args.trace, head_only=not args.all_flits)
+    events = packets.get(args.packet)
+    if not events:
+        sys.exit(f"packet {args.packet} is not in the trace")
+    for tick, event, flit, vnet, node, inp, outp, vc, dests in events:
+        where = "ni" if event in (ENQUEUE, INJECT, EJECT) else "router"
+        print(f"{tick:>14} flit {flit:<3} {EVENT_NAMES[event]:<10} "
+              f"{where} {node:<4} in {port(inp):>3} out {port(outp):>3} "
+              f"vc {vc:<3} dests {dests}")
+    b = breakdown(events)
+    if b:
+        for ni, tick in sorted(b["ejects"]):
+            print(f"ni {ni}: {tick - b['inject']} ticks in the network")
+
+
+def cmd_csv(args):
+    packets = load_packets(args.trace, head_only=True)
+    with open(args.output, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["packet", "vnet", "src", "dest", "source_ticks",
+                         "network_ticks", "packet_router_ticks",
+                         "packet_router_visits"])
+        for packet in sorted(packets):
+            b = breakdown(packets[packet])
+            if b is None:
+                continue
+            for ni, tick in sorted(b["ejects"]):
+                writer.writerow([packet, b["vnet"], b["src"], ni,
+                                 b["source_ticks"], tick - b["inject"],
+                                 b["router_ticks"], b["router_visits"]])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("trace", help="flit trace file")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    sub.add_parser("summary", help="latency breakdown per vnet")
+
+    path = sub.add_parser("path", help="events of one packet")
+    path.add_argument("packet", type=int)
+    path.add_argument("--all-flits", action="store_true",
+                      help="show the body and tail flits too")
+
+    out = sub.add_parser("csv", help="one row per packet and destination")
+    out.add_argument("output")
+
+    args = parser.parse_args()
+    {"summary": cmd_summary, "path": cmd_path, "csv": cmd_csv}[
+        args.command](args)
+
+
+if __name__ == "__main__":
+    main()